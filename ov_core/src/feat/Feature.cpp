@@ -26,7 +26,7 @@ using namespace ov_core;
 
 
 
-void Feature::clean_old_measurements(std::vector<double> valid_times) {
+void Feature::clean_old_measurements(const std::vector<double> &valid_times) {
 
 
     // Loop through each of the cameras we have
@@ -36,23 +36,26 @@ void Feature::clean_old_measurements(std::vector<double> valid_times) {
         assert(timestamps[pair.first].size() == uvs[pair.first].size());
         assert(timestamps[pair.first].size() == uvs_norm[pair.first].size());
 
-        // Our iterators
-        auto it1 = timestamps[pair.first].begin();
-        auto it2 = uvs[pair.first].begin();
-        auto it3 = uvs_norm[pair.first].begin();
-
-        // Loop through measurement times, remove ones that are not in our timestamps
-        while (it1 != timestamps[pair.first].end()) {
-            if (std::find(valid_times.begin(),valid_times.end(),*it1) == valid_times.end()) {
-                it1 = timestamps[pair.first].erase(it1);
-                it2 = uvs[pair.first].erase(it2);
-                it3 = uvs_norm[pair.first].erase(it3);
-            } else {
-                ++it1;
-                ++it2;
-                ++it3;
+        // Our measurement arrays for this camera
+        std::vector<double> &times = timestamps[pair.first];
+        std::vector<Eigen::Vector2f> &uv = uvs[pair.first];
+        std::vector<Eigen::Vector2f> &uv_norm = uvs_norm[pair.first];
+
+        // Loop through measurement times, and move the ones that are in our timestamps to the front
+        size_t ct_keep = 0;
+        for (size_t m = 0; m < times.size(); m++) {
+            if (std::find(valid_times.begin(),valid_times.end(),times[m]) != valid_times.end()) {
+                times[ct_keep] = times[m];
+                uv[ct_keep] = uv[m];
+                uv_norm[ct_keep] = uv_norm[m];
+                ct_keep++;
             }
         }
+
+        // Remove the rest, this keeps the capacity of our arrays
+        times.resize(ct_keep);
+        uv.resize(ct_keep);
+        uv_norm.resize(ct_keep);
     }
 
 }
@@ -67,25 +70,26 @@ void Feature::clean_older_measurements(double timestamp) {
         assert(timestamps[pair.first].size() == uvs[pair.first].size());
         assert(timestamps[pair.first].size() == uvs_norm[pair.first].size());
 
-        // Our iterators
-        auto it1 = timestamps[pair.first].begin();
-        auto it2 = uvs[pair.first].begin();
-        auto it3 = uvs_norm[pair.first].begin();
-
-        // Loop through measurement times, remove ones that are older then the specified one
-        while (it1 != timestamps[pair.first].end()) {
-            if (*it1 <= timestamp) {
-                it1 = timestamps[pair.first].erase(it1);
-                it2 = uvs[pair.first].erase(it2);
-                it3 = uvs_norm[pair.first].erase(it3);
-            } else {
-                ++it1;
-                ++it2;
-                ++it3;
+        // Our measurement arrays for this camera
+        std::vector<double> &times = timestamps[pair.first];
+        std::vector<Eigen::Vector2f> &uv = uvs[pair.first];
+        std::vector<Eigen::Vector2f> &uv_norm = uvs_norm[pair.first];
+
+        // Loop through measurement times, and move the ones that are newer then the specified one to the front
+        size_t ct_keep = 0;
+        for (size_t m = 0; m < times.size(); m++) {
+            if (times[m] > timestamp) {
+                times[ct_keep] = times[m];
+                uv[ct_keep] = uv[m];
+                uv_norm[ct_keep] = uv_norm[m];
+                ct_keep++;
             }
         }
+
+        // Remove the rest, this keeps the capacity of our arrays
+        times.resize(ct_keep);
+        uv.resize(ct_keep);
+        uv_norm.resize(ct_keep);
     }
 
 }
-
-
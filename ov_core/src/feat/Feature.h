@@ -47,10 +47,11 @@ namespace ov_core {
         bool to_delete;
 
         /// UV coordinates that this feature has been seen from (mapped by camera ID)
-        std::unordered_map<size_t, std::vector<Eigen::VectorXf>> uvs;
+        /// Each camera has a contiguous array of fixed size coordinates, so a measurement does not need its own allocation
+        std::unordered_map<size_t, std::vector<Eigen::Vector2f>> uvs;
 
         /// UV normalized coordinates that this feature has been seen from (mapped by camera ID)
-        std::unordered_map<size_t, std::vector<Eigen::VectorXf>> uvs_norm;
+        std::unordered_map<size_t, std::vector<Eigen::Vector2f>> uvs_norm;
 
         /// Timestamps of each UV measurement (mapped by camera ID)
         std::unordered_map<size_t, std::vector<double>> timestamps;
@@ -76,7 +77,7 @@ namespace ov_core {
          *
          * @param valid_times Vector of timestamps that our measurements must occur at
          */
-        void clean_old_measurements(std::vector<double> valid_times);
+        void clean_old_measurements(const std::vector<double> &valid_times);
 
         /**
          * @brief Remove measurements that are older then the specified timestamp.
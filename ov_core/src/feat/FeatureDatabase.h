@@ -23,10 +23,18 @@
 
 
 #include <vector>
+#include <deque>
+#include <map>
+#include <unordered_map>
+#include <algorithm>
 #include <mutex>
+#include <memory>
+#include <functional>
 #include <Eigen/Eigen>
 
 #include "Feature.h"
+#include "ObservationRing.h"
+#include "utils/colors.h"
 
 
 namespace ov_core {
@@ -38,6 +46,18 @@ namespace ov_core {
      * The trackers will insert information into this database when they get new measurements from doing tracking.
      * A user would then query this database for features that can be used for update and remove them after they have been processed.
      *
+     * To avoid scanning all features on each query, we keep a secondary index of the features that have a measurement at each timestamp,
+     * and of the features bucketed by their newest measurement time.
+     * Each index is a small sorted array of times, each holding an array of ids which keeps its capacity when the time is recycled.
+     * Thus adding a measurement to an existing feature never allocates, which is done for every tracked feature on each frame.
+     * Removed features and old newest times are not erased from the index, but are dropped once their time is queried or cleaned up.
+     * An updater might remove measurements of a feature it did not remove, so the newest times are refreshed in cleanup() and cleanup_measurements().
+     * Thus cleanup() should be called after each update, and all query results are still verified against the feature.
+     *
+     * All features are owned by a pool inside of this database, so their pointers stay valid until the database is destroyed.
+     * Features which are deleted are recycled for new tracks, and keep the capacity of their measurement arrays.
+     * This keeps the tracking thread from allocating and freeing a feature for each track that is born and dies.
+     *
      *
      * @m_class{m-note m-warning}
      *
@@ -49,6 +69,11 @@ namespace ov_core {
      * For example, if you are asynchronous tracking cameras and you chose to update the state, then remove all features you will use in update.
      * The feature trackers will continue to add features while you update, whose measurements can be used in the next update step!
      *
+     * If enable_observation_rings() has been called, then update_feature() will not lock the database.
+     * Instead each camera has a lock-free ring that observations are pushed into, and each tracker publishes its observations once per frame.
+     * These observations are only inserted into the database once the estimator calls ingest_observations().
+     * Thus the trackers never block on the estimator, and the estimator sees a consistent set of frames during its update.
+     *
      */
     class FeatureDatabase {
 
@@ -65,14 +90,17 @@ namespace ov_core {
         /**
          * @brief Get a specified feature
          * @param id What feature we want to get
-         * @param remove Set to true if you want to remove the feature from the database (you will need to handle the freeing of memory)
+         * @param remove Set to true if you want to remove the feature from the database (give it back with recycle_feature() when done)
          * @return Either a feature object, or null if it is not in the database.
          */
         Feature *get_feature(size_t id, bool remove=false) {
             std::unique_lock<std::mutex> lck(mtx);
             if (features_idlookup.find(id) != features_idlookup.end()) {
                 Feature* temp = features_idlookup[id];
-                if(remove) features_idlookup.erase(id);
+                if(remove) {
+                    index_remove(temp);
+                    features_idlookup.erase(id);
+                }
                 return temp;
             } else {
                 return nullptr;
@@ -80,6 +108,26 @@ namespace ov_core {
         }
 
 
+        /**
+         * @brief Will send all observations through lock-free rings instead of directly into the database.
+         *
+         * This should be called before any tracking has been done.
+         * Each camera gets its own ring, as each camera is only ever tracked by a single thread at a time.
+         * Observations of cameras without a ring will still be directly inserted.
+         *
+         * @param num_cameras Number of cameras we will create a ring for (camera ids 0 to num_cameras-1)
+         * @param capacity Max number of observations that can be waiting in each ring
+         */
+        void enable_observation_rings(size_t num_cameras, size_t capacity) {
+            std::unique_lock<std::mutex> lck(mtx);
+            observation_rings.clear();
+            for (size_t i = 0; i < num_cameras; i++) {
+                observation_rings.emplace_back(new ObservationRing(capacity));
+            }
+            observation_rings_warned.assign(num_cameras, false);
+        }
+
+
         /**
          * @brief Update a feature object
          * @param id ID of the feature we will update
@@ -92,34 +140,153 @@ namespace ov_core {
          *
          * This will update a given feature based on the passed ID it has.
          * It will create a new feature, if it is an ID that we have not seen before.
+         * If this camera has an observation ring, then the measurement is only added once it has been published and ingested.
          */
         void update_feature(size_t id, double timestamp, size_t cam_id,
                             float u, float v, float u_n, float v_n) {
 
-            // Find this feature using the ID lookup
+            // If we have a ring for this camera, then push into it without locking
+            // If it is full, then the whole frame is dropped once it is published
+            if (cam_id < observation_rings.size()) {
+                observation_rings.at(cam_id)->push({id, timestamp, cam_id, u, v, u_n, v_n});
+                return;
+            }
+
+            // Else directly add it to our database
             std::unique_lock<std::mutex> lck(mtx);
-            if (features_idlookup.find(id) != features_idlookup.end()) {
-                // Get our feature
-                Feature *feat = features_idlookup[id];
-                // Append this new information to it!
-                feat->uvs[cam_id].emplace_back(Eigen::Vector2f(u, v));
-                feat->uvs_norm[cam_id].emplace_back(Eigen::Vector2f(u_n, v_n));
-                feat->timestamps[cam_id].emplace_back(timestamp);
+            update_feature_internal(id, timestamp, cam_id, u, v, u_n, v_n);
+        }
+
+
+        /**
+         * @brief Update a set of feature objects, only locking the database once
+         * @param observations Measurements we want to add (these should all be from the same camera and time)
+         *
+         * This behaves the same as calling update_feature() on each of the observations in order.
+         * Trackers should use this so they only need a single database lock for each image.
+         */
+        void update_features(const std::vector<ObservationRing::Observation> &observations) {
+
+            // Nothing to do if we have no observations
+            if (observations.empty())
+                return;
+
+            // If we have a ring for this camera, then push into it without locking
+            // If they do not all fit, then the whole frame is dropped once it is published
+            size_t cam_id = observations.at(0).cam_id;
+            if (cam_id < observation_rings.size()) {
+                observation_rings.at(cam_id)->push(observations);
                 return;
             }
 
-            // Debug info
-            //ROS_INFO("featdb - adding new feature %d",(int)id);
+            // Else directly add them to our database
+            std::unique_lock<std::mutex> lck(mtx);
+            for (const auto &obs : observations) {
+                update_feature_internal(obs.id, obs.timestamp, obs.cam_id, obs.u, obs.v, obs.u_n, obs.v_n);
+            }
+        }
 
-            // Else we have not found the feature, so lets make it be a new one!
-            Feature *feat = new Feature();
-            feat->featid = id;
-            feat->uvs[cam_id].emplace_back(Eigen::Vector2f(u, v));
-            feat->uvs_norm[cam_id].emplace_back(Eigen::Vector2f(u_n, v_n));
-            feat->timestamps[cam_id].emplace_back(timestamp);
 
-            // Append this new feature into our database
-            features_idlookup.insert({id, feat});
+        /**
+         * @brief Publishes all observations of a camera pushed since the last call
+         *
+         * Trackers should call this after they have added all observations of a frame.
+         * If the ring did not have room for all of them, then the whole frame is dropped.
+         * We only warn the first time this happens for each camera, see get_num_dropped() for the total.
+         * This does nothing if this camera does not have an observation ring.
+         *
+         * @param cam_id Camera we want to publish the observations of
+         */
+        void publish_observations(size_t cam_id) {
+            if (cam_id < observation_rings.size()) {
+                size_t num_dropped = observation_rings.at(cam_id)->publish();
+                if (num_dropped > 0 && !observation_rings_warned.at(cam_id)) {
+                    printf(YELLOW "[FEATDB]: observation ring of cam %d is full, dropping frame with %d measurements (only warning once)\n" RESET, (int)cam_id, (int)num_dropped);
+                    observation_rings_warned.at(cam_id) = true;
+                }
+            }
+        }
+
+
+        /// Total number of observations that where dropped since an observation ring was full
+        size_t get_num_dropped() {
+            size_t num_dropped = 0;
+            for (const auto &ring : observation_rings) {
+                num_dropped += ring->get_num_dropped();
+            }
+            return num_dropped;
+        }
+
+
+        /**
+         * @brief Inserts all published observations into our database
+         *
+         * This should be called by the estimator before it starts to query this database for a new frame.
+         * The observations of each camera are inserted in the order they where tracked.
+         *
+         * @return Number of observations that where inserted
+         */
+        size_t ingest_observations() {
+            std::unique_lock<std::mutex> lck(mtx);
+            size_t ct_obs = 0;
+            for (auto &ring : observation_rings) {
+                ct_obs += ring->pop_all([this](const ObservationRing::Observation &obs) {
+                    update_feature_internal(obs.id, obs.timestamp, obs.cam_id, obs.u, obs.v, obs.u_n, obs.v_n);
+                });
+            }
+            return ct_obs;
+        }
+
+
+        /**
+         * @brief Inserts all published observations up to a given time into our database
+         *
+         * Observations of frames newer than the requested time are left in the rings for a later call.
+         * This allows the estimator to lag behind the trackers while still seeing exactly the frames it has processed.
+         *
+         * The observations of each camera can be re-normalized before they are inserted.
+         * This is needed if the calibration has changed since they where tracked, as their normalized coordinates are then stale.
+         *
+         * @param timestamp Newest measurement time we want to insert
+         * @param normalize Function that will re-normalize the observations of a single camera in place (can be empty)
+         * @return Number of observations that where inserted
+         */
+        size_t ingest_observations(double timestamp, const std::function<void(std::vector<ObservationRing::Observation>&)> &normalize = nullptr) {
+            size_t ct_obs = 0;
+            for (auto &ring : observation_rings) {
+                // Only we pop from the rings, so we do not need to lock till we insert
+                ingest_buffer.clear();
+                ring->pop_until(timestamp, [this](const ObservationRing::Observation &obs) {
+                    ingest_buffer.push_back(obs);
+                });
+                if (ingest_buffer.empty())
+                    continue;
+                if (normalize)
+                    normalize(ingest_buffer);
+                std::unique_lock<std::mutex> lck(mtx);
+                for (const auto &obs : ingest_buffer) {
+                    update_feature_internal(obs.id, obs.timestamp, obs.cam_id, obs.u, obs.v, obs.u_n, obs.v_n);
+                }
+                ct_obs += ingest_buffer.size();
+            }
+            return ct_obs;
+        }
+
+
+        /**
+         * @brief Throws away all published observations up to a given time without inserting them
+         *
+         * This should be used by the estimator for frames it has skipped, so their observations are not inserted with a later frame.
+         *
+         * @param timestamp Newest measurement time we want to throw away
+         * @return Number of observations that where thrown away
+         */
+        size_t discard_observations(double timestamp) {
+            size_t ct_obs = 0;
+            for (auto &ring : observation_rings) {
+                ct_obs += ring->pop_until(timestamp, [](const ObservationRing::Observation &) {});
+            }
+            return ct_obs;
         }
 
 
@@ -135,26 +302,43 @@ namespace ov_core {
             // Our vector of features that do not have measurements after the specified time
             std::vector<Feature *> feats_old;
 
-            // Now lets loop through all features, and just make sure they are not old
+            // Only features whose newest measurement is before the specified time can be old
             std::unique_lock<std::mutex> lck(mtx);
-            for (auto it = features_idlookup.begin(); it != features_idlookup.end();) {
-                // Loop through each camera
-                bool has_newer_measurement = false;
-                for (auto const &pair : (*it).second->timestamps) {
-                    // If we have a measurement greater-than or equal to the specified, this measurement is find
-                    if (!pair.second.empty() && pair.second.at(pair.second.size() - 1) >= timestamp) {
-                        has_newer_measurement = true;
-                        break;
+            auto it_end = index_lower_bound(features_bynewest, timestamp);
+            for (auto it = features_bynewest.begin(); it != it_end; it++) {
+                // Drop the ids of removed features, features that have a newer measurement since, and any id recorded more than once
+                std::vector<size_t> &ids = (*it).ids;
+                double time = (*it).timestamp;
+                ids.erase(std::remove_if(ids.begin(), ids.end(), [this, time](size_t id) {
+                    auto it_newest = features_newest.find(id);
+                    return it_newest == features_newest.end() || (*it_newest).second != time;
+                }), ids.end());
+                std::sort(ids.begin(), ids.end());
+                ids.erase(std::unique(ids.begin(), ids.end()), ids.end());
+                for (const auto &id : ids) {
+                    // Loop through each camera
+                    Feature *feat = features_idlookup.at(id);
+                    bool has_newer_measurement = false;
+                    for (auto const &pair : feat->timestamps) {
+                        // If we have a measurement greater-than or equal to the specified, this measurement is find
+                        if (!pair.second.empty() && pair.second.at(pair.second.size() - 1) >= timestamp) {
+                            has_newer_measurement = true;
+                            break;
+                        }
+                    }
+                    // If it is not being actively tracked, then it is old
+                    if (!has_newer_measurement) {
+                        feats_old.push_back(feat);
                     }
                 }
-                // If it is not being actively tracked, then it is old
-                if (!has_newer_measurement) {
-                    feats_old.push_back((*it).second);
-                    if(remove) features_idlookup.erase(it++);
-                    else it++;
-                } else {
-                    it++;
-                }
+            }
+
+            // Recycle the times which no longer have any features
+            index_recycle_empty(features_bynewest, it_end);
+
+            // Remove them from our database if requested
+            if(remove) {
+                remove_features(feats_old);
             }
 
             // Debugging
@@ -177,12 +361,24 @@ namespace ov_core {
             // Our vector of old features
             std::vector<Feature *> feats_old;
 
-            // Now lets loop through all features, and just make sure they are not old
+            // Only features seen at a time before the specified time can be older
+            // A feature can be in more than one of these times, so we only check each once
             std::unique_lock<std::mutex> lck(mtx);
-            for (auto it = features_idlookup.begin(); it != features_idlookup.end();) {
+            std::vector<size_t> ids_older;
+            for (auto it = features_bytimestamp.begin(); it != index_lower_bound(features_bytimestamp, timestamp); it++) {
+                ids_older.insert(ids_older.end(), (*it).ids.begin(), (*it).ids.end());
+            }
+            std::sort(ids_older.begin(), ids_older.end());
+            ids_older.erase(std::unique(ids_older.begin(), ids_older.end()), ids_older.end());
+            for (const auto &id : ids_older) {
+                // Skip if this feature has been removed
+                if (features_idlookup.find(id) == features_idlookup.end()) {
+                    continue;
+                }
                 // Loop through each camera
+                Feature *feat = features_idlookup.at(id);
                 bool found_containing_older = false;
-                for (auto const &pair : (*it).second->timestamps) {
+                for (auto const &pair : feat->timestamps) {
                     if (!pair.second.empty() && pair.second.at(0) < timestamp) {
                         found_containing_older = true;
                         break;
@@ -190,14 +386,15 @@ namespace ov_core {
                 }
                 // If it has an older timestamp, then add it
                 if(found_containing_older) {
-                    feats_old.push_back((*it).second);
-                    if(remove) features_idlookup.erase(it++);
-                    else it++;
-                } else {
-                    it++;
+                    feats_old.push_back(feat);
                 }
             }
 
+            // Remove them from our database if requested
+            if(remove) {
+                remove_features(feats_old);
+            }
+
             // Debugging
             //std::cout << "feature db size = " << features_idlookup.size() << std::endl;
 
@@ -217,34 +414,43 @@ namespace ov_core {
             // Our vector of old features
             std::vector<Feature *> feats_has_timestamp;
 
-            // Now lets loop through all features, and just make sure they are not
+            // Return if no feature has been seen at this time
             std::unique_lock<std::mutex> lck(mtx);
-            for (auto it = features_idlookup.begin(); it != features_idlookup.end();) {
+            auto it = index_lower_bound(features_bytimestamp, timestamp);
+            if (it == features_bytimestamp.end() || (*it).timestamp != timestamp) {
+                return feats_has_timestamp;
+            }
+
+            // Drop the ids of removed features, and any id that was recorded more than once
+            std::vector<size_t> &ids = (*it).ids;
+            ids.erase(std::remove_if(ids.begin(), ids.end(), [this](size_t id) {
+                return features_idlookup.find(id) == features_idlookup.end();
+            }), ids.end());
+            std::sort(ids.begin(), ids.end());
+            ids.erase(std::unique(ids.begin(), ids.end()), ids.end());
+
+            // Now lets loop through all features seen at this time, and make sure they still have it
+            for (const auto &id : ids) {
                 // Boolean if it has the timestamp
+                Feature *feat = features_idlookup.at(id);
                 bool has_timestamp = false;
-                for (auto const &pair : (*it).second->timestamps) {
-                    // Loop through all timestamps, and see if it has it
-                    for (auto &timefeat : pair.second) {
-                        if (timefeat == timestamp) {
-                            has_timestamp = true;
-                            break;
-                        }
-                    }
-                    // Break out if we found a single timestamp that is equal to the specified time
-                    if (has_timestamp) {
+                for (auto const &pair : feat->timestamps) {
+                    if (std::find(pair.second.begin(), pair.second.end(), timestamp) != pair.second.end()) {
+                        has_timestamp = true;
                         break;
                     }
                 }
-                // Remove this feature if it contains the specified timestamp
+                // Return this feature if it contains the specified timestamp
                 if (has_timestamp) {
-                    feats_has_timestamp.push_back((*it).second);
-                    if(remove) features_idlookup.erase(it++);
-                    else it++;
-                } else {
-                    it++;
+                    feats_has_timestamp.push_back(feat);
                 }
             }
 
+            // Remove them from our database if requested
+            if(remove) {
+                remove_features(feats_has_timestamp);
+            }
+
             // Debugging
             //std::cout << "feature db size = " << features_idlookup.size() << std::endl;
             //std::cout << "return vector = " << feats_has_timestamp.size() << std::endl;
@@ -257,7 +463,9 @@ namespace ov_core {
         /**
          * @brief This function will delete all features that have been used up.
          *
-         * If a feature was unable to be used, it will still remain since it will not have a delete flag set
+         * If a feature was unable to be used, it will still remain since it will not have a delete flag set.
+         * Since we need to visit every feature here, we also refresh the newest time of each remaining feature.
+         * This picks up any measurements that the updaters have removed from features which are still in this database.
          */
         void cleanup() {
             // Debug
@@ -267,9 +475,11 @@ namespace ov_core {
             for (auto it = features_idlookup.begin(); it != features_idlookup.end();) {
                 // If delete flag is set, then delete it
                 if ((*it).second->to_delete) {
-                    delete (*it).second;
+                    index_remove((*it).second);
+                    free_feature((*it).second);
                     features_idlookup.erase(it++);
                 } else {
+                    index_set_newest((*it).first, get_newest_time((*it).second));
                     it++;
                 }
             }
@@ -279,6 +489,9 @@ namespace ov_core {
 
         /**
          * @brief This function will delete all feature measurements that are older then the specified timestamp
+         *
+         * Since we need to visit every feature here, we also refresh the newest time of each feature.
+         * This picks up any measurements that have been removed from features outside of this database.
          */
         void cleanup_measurements(double timestamp) {
             std::unique_lock<std::mutex> lck(mtx);
@@ -292,12 +505,32 @@ namespace ov_core {
                 }
                 // If delete flag is set, then delete it
                 if (ct_meas < 1) {
-                    delete (*it).second;
+                    index_remove((*it).second);
+                    free_feature((*it).second);
                     features_idlookup.erase(it++);
                 } else {
+                    index_set_newest((*it).first, get_newest_time((*it).second));
                     it++;
                 }
             }
+            // None of our features have measurements older then this time now, so recycle the ids of those times
+            index_recycle(features_bytimestamp, timestamp);
+            index_recycle(features_bynewest, timestamp);
+        }
+
+
+        /**
+         * @brief Gives a feature which has been removed from this database back to our pool.
+         *
+         * Features returned with the "remove" flag are no longer tracked by this database.
+         * Once the user is done with them, they should be recycled here instead of being deleted.
+         *
+         * @param feat Feature that was removed from this database
+         */
+        void recycle_feature(Feature *feat) {
+            std::unique_lock<std::mutex> lck(mtx);
+            assert(features_idlookup.find(feat->featid) == features_idlookup.end() || features_idlookup.at(feat->featid) != feat);
+            free_feature(feat);
         }
 
 
@@ -320,16 +553,275 @@ namespace ov_core {
 
     protected:
 
+        /**
+         * @brief Ids of all features that have a measurement at a single time
+         */
+        struct TimeIds {
+
+            /// Time of the measurements
+            double timestamp;
+
+            /// Ids of the features (might have duplicates until they are queried)
+            std::vector<size_t> ids;
+
+        };
+
+        /**
+         * @brief Adds a measurement to a feature, or creates the feature if it is new (mutex should be locked)
+         *
+         * See update_feature() for details on the parameters.
+         */
+        void update_feature_internal(size_t id, double timestamp, size_t cam_id,
+                                     float u, float v, float u_n, float v_n) {
+
+            // Find this feature using the ID lookup
+            if (features_idlookup.find(id) != features_idlookup.end()) {
+                // Get our feature
+                Feature *feat = features_idlookup[id];
+                // Append this new information to it!
+                feat->uvs[cam_id].emplace_back(Eigen::Vector2f(u, v));
+                feat->uvs_norm[cam_id].emplace_back(Eigen::Vector2f(u_n, v_n));
+                feat->timestamps[cam_id].emplace_back(timestamp);
+                // Record this timestamp if it is not the newest we have (e.g. the second image of a stereo pair)
+                // Any time recorded twice is only removed lazily when queried
+                double newest = features_newest.at(id);
+                if (newest != timestamp) {
+                    index_add(features_bytimestamp, timestamp, id);
+                    if (timestamp > newest) {
+                        index_set_newest(id, timestamp);
+                    }
+                }
+                return;
+            }
+
+            // Debug info
+            //ROS_INFO("featdb - adding new feature %d",(int)id);
+
+            // Else we have not found the feature, so lets make it be a new one!
+            Feature *feat = allocate_feature();
+            feat->featid = id;
+            feat->uvs[cam_id].emplace_back(Eigen::Vector2f(u, v));
+            feat->uvs_norm[cam_id].emplace_back(Eigen::Vector2f(u_n, v_n));
+            feat->timestamps[cam_id].emplace_back(timestamp);
+
+            // Append this new feature into our database
+            features_idlookup.insert({id, feat});
+            index_insert(feat);
+        }
+
+        /**
+         * @brief Gets the newest measurement time of a feature
+         *
+         * Note that this assumes that each camera has its measurements sorted in time.
+         *
+         * @param feat Feature we want the newest time of
+         * @return Time of the newest measurement
+         */
+        static double get_newest_time(Feature *feat) {
+            double newest = -INFINITY;
+            for (auto const &pair : feat->timestamps) {
+                if (!pair.second.empty()) {
+                    newest = std::max(newest, pair.second.at(pair.second.size() - 1));
+                }
+            }
+            return newest;
+        }
+
+        /**
+         * @brief Adds a new feature to our time indices (mutex should be locked)
+         * @param feat Feature we want to add
+         */
+        void index_insert(Feature *feat) {
+            for (auto const &pair : feat->timestamps) {
+                for (auto const &timefeat : pair.second) {
+                    index_add(features_bytimestamp, timefeat, feat->featid);
+                }
+            }
+            double newest = get_newest_time(feat);
+            features_newest[feat->featid] = newest;
+            index_add(features_bynewest, newest, feat->featid);
+        }
+
+        /**
+         * @brief Removes a feature from our time indices (mutex should be locked)
+         *
+         * Its id is left at each of its times, and will be dropped once that time is queried or cleaned up.
+         *
+         * @param feat Feature we want to remove
+         */
+        void index_remove(Feature *feat) {
+            features_newest.erase(feat->featid);
+        }
+
+        /**
+         * @brief Changes the newest measurement time of a feature (mutex should be locked)
+         *
+         * The feature is added at its new time, while its old time is only dropped once it is queried or cleaned up.
+         *
+         * @param id ID of the feature
+         * @param newest Time of its newest measurement
+         */
+        void index_set_newest(size_t id, double newest) {
+            double &newest_old = features_newest.at(id);
+            if (newest_old != newest) {
+                newest_old = newest;
+                index_add(features_bynewest, newest, id);
+            }
+        }
+
+        /**
+         * @brief Gets the first time in an index which is not before the specified time (mutex should be locked)
+         * @param index Time index we want to search
+         * @param timestamp Time we want to find
+         * @return Iterator to the first time greater-than or equal to the specified
+         */
+        static std::vector<TimeIds>::iterator index_lower_bound(std::vector<TimeIds> &index, double timestamp) {
+            return std::lower_bound(index.begin(), index.end(), timestamp,
+                                    [](const TimeIds &time, double value) { return time.timestamp < value; });
+        }
+
+        /**
+         * @brief Records a feature at a time in an index (mutex should be locked)
+         *
+         * New times reuse the id array of a time that has been cleaned up, so this only allocates until our arrays have grown.
+         *
+         * @param index Time index we want to add to
+         * @param timestamp Time of the measurement
+         * @param id ID of the feature
+         */
+        void index_add(std::vector<TimeIds> &index, double timestamp, size_t id) {
+            auto it = index_lower_bound(index, timestamp);
+            if (it == index.end() || (*it).timestamp != timestamp) {
+                TimeIds time;
+                time.timestamp = timestamp;
+                if (!ids_free.empty()) {
+                    time.ids = std::move(ids_free.back());
+                    ids_free.pop_back();
+                }
+                it = index.insert(it, std::move(time));
+            }
+            (*it).ids.push_back(id);
+        }
+
+        /**
+         * @brief Recycles the id arrays of all times in an index before the specified time (mutex should be locked)
+         * @param index Time index we want to clean up
+         * @param timestamp All times before this will be removed
+         */
+        void index_recycle(std::vector<TimeIds> &index, double timestamp) {
+            auto it_end = index_lower_bound(index, timestamp);
+            for (auto it = index.begin(); it != it_end; it++) {
+                (*it).ids.clear();
+                ids_free.push_back(std::move((*it).ids));
+            }
+            index.erase(index.begin(), it_end);
+        }
+
+        /**
+         * @brief Recycles the id arrays of all times in an index before the specified position which have no ids (mutex should be locked)
+         * @param index Time index we want to clean up
+         * @param it_end Only times before this position will be removed
+         */
+        void index_recycle_empty(std::vector<TimeIds> &index, std::vector<TimeIds>::iterator it_end) {
+            auto it_out = index.begin();
+            for (auto it = index.begin(); it != it_end; it++) {
+                if ((*it).ids.empty()) {
+                    ids_free.push_back(std::move((*it).ids));
+                    continue;
+                }
+                if (it_out != it) {
+                    *it_out = std::move(*it);
+                }
+                it_out++;
+            }
+            index.erase(it_out, it_end);
+        }
+
+        /**
+         * @brief Removes the features from our database without freeing them (mutex should be locked)
+         * @param feats Features we want to remove
+         */
+        void remove_features(const std::vector<Feature *> &feats) {
+            for (const auto &feat : feats) {
+                index_remove(feat);
+                features_idlookup.erase(feat->featid);
+            }
+        }
+
+        /**
+         * @brief Gets a feature from our pool, or creates a new one if none are free (mutex should be locked)
+         * @return Feature with no measurements
+         */
+        Feature *allocate_feature() {
+            if (features_free.empty()) {
+                features_pool.emplace_back();
+                return &features_pool.back();
+            }
+            Feature *feat = features_free.back();
+            features_free.pop_back();
+            return feat;
+        }
+
+        /**
+         * @brief Clears a feature and puts it back into our pool (mutex should be locked)
+         *
+         * We only clear the measurement arrays of each camera so they can be reused without allocating.
+         *
+         * @param feat Feature we no longer need
+         */
+        void free_feature(Feature *feat) {
+            for (auto &pair : feat->timestamps) {
+                pair.second.clear();
+            }
+            for (auto &pair : feat->uvs) {
+                pair.second.clear();
+            }
+            for (auto &pair : feat->uvs_norm) {
+                pair.second.clear();
+            }
+            feat->to_delete = false;
+            feat->anchor_cam_id = -1;
+            feat->anchor_clone_timestamp = -1;
+            features_free.push_back(feat);
+        }
+
         /// Mutex lock for our map
         std::mutex mtx;
 
         /// Our lookup array that allow use to query based on ID
         std::unordered_map<size_t, Feature *> features_idlookup;
 
+        /// Features that have had a measurement at each timestamp, sorted by time (might still contain removed features and measurements)
+        std::vector<TimeIds> features_bytimestamp;
+
+        /// Id arrays of times that have been cleaned up, which we reuse for new times
+        std::vector<std::vector<size_t>> ids_free;
+
+        /// Newest measurement time of each feature (might be newer if measurements have been removed outside of this database since the last cleanup)
+        std::unordered_map<size_t, double> features_newest;
+
+        /// Features bucketed by their newest measurement time, sorted by time (an id is only valid at the time it has in features_newest)
+        std::vector<TimeIds> features_bynewest;
+
+        /// Storage of all features we have created (a deque never moves its elements, so pointers into it stay valid)
+        std::deque<Feature> features_pool;
+
+        /// Features in our pool which are not currently used
+        std::vector<Feature *> features_free;
+
+        /// Lock-free ring of observations for each camera (empty if we directly insert observations)
+        std::vector<std::unique_ptr<ObservationRing>> observation_rings;
+
+        /// If we have warned about a dropped frame of each camera (a char so each tracker only writes its own byte)
+        std::vector<char> observation_rings_warned;
+
+        /// Observations popped from a ring that are about to be inserted, this is only used by the estimator
+        std::vector<ObservationRing::Observation> ingest_buffer;
+
 
     };
 
 
 }
 
-#endif /* OV_CORE_FEATURE_DATABASE_H */
\ No newline at end of file
+#endif /* OV_CORE_FEATURE_DATABASE_H */
@@ -342,3 +342,262 @@ bool FeatureInitializer::single_gaussnewton(Feature* feat, std::unordered_map<si
     return true;
 
 }
+
+
+
+void FeatureInitializer::batch_triangulation(const std::vector<Feature*> &feats, std::unordered_map<size_t,std::unordered_map<double,ClonePose>> &clonesCAM,
+                                             std::vector<char> &success) {
+
+    // Nothing is a success until it has been refined
+    size_t num_feats = feats.size();
+    success.assign(num_feats, false);
+
+    // Count the measurements of each feature, so they can be stored one after the other
+    // Also set the last measurement of the camera with the most to be the anchor frame
+    std::vector<size_t> meas_start(num_feats+1, 0);
+    for(size_t f=0; f<num_feats; f++) {
+        size_t total_meas = 0;
+        size_t anchor_most_meas = 0;
+        size_t most_meas = 0;
+        for (auto const& pair : feats.at(f)->timestamps) {
+            total_meas += pair.second.size();
+            if(pair.second.size() > most_meas) {
+                anchor_most_meas = pair.first;
+                most_meas = pair.second.size();
+            }
+        }
+        feats.at(f)->anchor_cam_id = anchor_most_meas;
+        feats.at(f)->anchor_clone_timestamp = feats.at(f)->timestamps.at(anchor_most_meas).back();
+        meas_start.at(f+1) = meas_start.at(f) + total_meas;
+    }
+
+    // Pose of each measurement relative to its anchor, and its normalized coordinate
+    // This is the only place we look up the clone poses, everything after only reads these arrays
+    size_t num_meas = meas_start.at(num_feats);
+    std::vector<Eigen::Matrix<double,3,3>> R_GtoA(num_feats);
+    std::vector<Eigen::Matrix<double,3,1>> p_AinG(num_feats);
+    std::vector<Eigen::Matrix<double,3,3>> R_AtoCi(num_meas);
+    std::vector<Eigen::Matrix<double,3,1>> p_CiinA(num_meas);
+    std::vector<Eigen::Matrix<double,3,1>> p_AinCi(num_meas);
+    std::vector<Eigen::Matrix<float,2,1>> uv_norm(num_meas);
+    for(size_t f=0; f<num_feats; f++) {
+        Feature* feat = feats.at(f);
+        ClonePose &anchorclone = clonesCAM.at(feat->anchor_cam_id).at(feat->anchor_clone_timestamp);
+        R_GtoA.at(f) = anchorclone.Rot();
+        p_AinG.at(f) = anchorclone.pos();
+        size_t c = meas_start.at(f);
+        for (auto const& pair : feat->timestamps) {
+            std::unordered_map<double,ClonePose> &clonesCAMi = clonesCAM.at(pair.first);
+            for (size_t m = 0; m < pair.second.size(); m++) {
+                ClonePose &clone = clonesCAMi.at(pair.second.at(m));
+                R_AtoCi[c].noalias() = clone.Rot()*R_GtoA[f].transpose();
+                p_CiinA[c].noalias() = R_GtoA[f]*(clone.pos()-p_AinG[f]);
+                p_AinCi[c].noalias() = -R_AtoCi[c]*p_CiinA[c];
+                uv_norm[c] = feat->uvs_norm.at(pair.first).at(m);
+                c++;
+            }
+        }
+    }
+
+    // Error of a feature at a given estimate (same as compute_error())
+    auto compute_cost = [&](size_t f, double alpha, double beta, double rho) {
+        double err = 0;
+        for(size_t c=meas_start[f]; c<meas_start[f+1]; c++) {
+            Eigen::Matrix<double,3,1> h = R_AtoCi[c].col(0)*alpha + R_AtoCi[c].col(1)*beta + R_AtoCi[c].col(2) + rho*p_AinCi[c];
+            Eigen::Matrix<float, 2, 1> z;
+            z << h(0) / h(2), h(1) / h(2);
+            Eigen::Matrix<float, 2, 1> res = uv_norm[c] - z;
+            err += std::pow(res.norm(), 2);
+        }
+        return err;
+    };
+
+    //=====================================================================================
+    // LINEAR TRIANGULATION
+    //=====================================================================================
+
+    // State of each feature in its Levenberg-Marquardt refinement
+    struct RefineState {
+        bool triangulated = false;
+        bool active = false;
+        bool recompute = true;
+        int runs = 0;
+        double lam, eps, cost_old;
+        double alpha, beta, rho;
+        Eigen::Matrix<double,3,3> Hess;
+        Eigen::Matrix<double,3,1> grad;
+    };
+    std::vector<RefineState> states(num_feats);
+
+    for(size_t f=0; f<num_feats; f++) {
+
+        // Each measurement gives the two rows Bperp*p_f = Bperp*p_CiinA, so we directly sum up A^T*A and A^T*b
+        Eigen::Matrix<double,3,3> AtA = Eigen::Matrix<double,3,3>::Zero();
+        Eigen::Matrix<double,3,1> Atb = Eigen::Matrix<double,3,1>::Zero();
+        for(size_t c=meas_start[f]; c<meas_start[f+1]; c++) {
+            Eigen::Matrix<double,3,1> b_i;
+            b_i << uv_norm[c](0), uv_norm[c](1), 1;
+            b_i = R_AtoCi[c].transpose() * b_i;
+            b_i = b_i / b_i.norm();
+            Eigen::Matrix<double,2,3> Bperp;
+            Bperp << -b_i(2, 0), 0, b_i(0, 0), 0, b_i(2, 0), -b_i(1, 0);
+            Eigen::Matrix<double,3,3> BtB;
+            BtB.noalias() = Bperp.transpose()*Bperp;
+            AtA += BtB;
+            Atb.noalias() += BtB*p_CiinA[c];
+        }
+
+        // The singular values of A are the square root of the eigenvalues of A^T*A
+        Eigen::SelfAdjointEigenSolver<Eigen::Matrix<double,3,3>> eig;
+        eig.computeDirect(AtA, Eigen::EigenvaluesOnly);
+        double condA = std::sqrt(eig.eigenvalues()(2) / eig.eigenvalues()(0));
+        Eigen::Matrix<double,3,1> p_f = AtA.ldlt().solve(Atb);
+
+        // If we have a bad condition number, or it is too close
+        // Then set the flag for bad (i.e. set z-axis to nan)
+        if (!(eig.eigenvalues()(0) > 0) || std::abs(condA) > _options.max_cond_number
+            || p_f(2,0) < _options.min_dist || p_f(2,0) > _options.max_dist || std::isnan(p_f.norm())) {
+            continue;
+        }
+        feats.at(f)->p_FinA = p_f;
+        feats.at(f)->p_FinG = R_GtoA[f].transpose()*p_f + p_AinG[f];
+
+        // Get into inverse depth and start refining this feature
+        RefineState &st = states.at(f);
+        st.triangulated = true;
+        st.active = true;
+        st.rho = 1/p_f(2);
+        st.alpha = p_f(0)/p_f(2);
+        st.beta = p_f(1)/p_f(2);
+        st.lam = _options.init_lamda;
+        st.eps = 10000;
+        st.cost_old = compute_cost(f, st.alpha, st.beta, st.rho);
+
+    }
+
+    //=====================================================================================
+    // GAUSS-NEWTON REFINEMENT
+    //=====================================================================================
+
+    // Each pass does one iteration of single_gaussnewton() for every feature that is still refining
+    // A feature stops when it has either
+    // 1. Reached our max iteration count
+    // 2. System is unstable
+    // 3. System has converged
+    bool any_active = true;
+    while(any_active) {
+        any_active = false;
+        for(size_t f=0; f<num_feats; f++) {
+
+            RefineState &st = states[f];
+            if(!st.active)
+                continue;
+            if(!(st.runs < _options.max_runs && st.lam < _options.max_lamda && st.eps > _options.min_dx)) {
+                st.active = false;
+                continue;
+            }
+            any_active = true;
+
+            // Triggers a recomputation of jacobians/information/gradients
+            if(st.recompute) {
+                st.Hess.setZero();
+                st.grad.setZero();
+                for(size_t c=meas_start[f]; c<meas_start[f+1]; c++) {
+                    const Eigen::Matrix<double,3,3> &R = R_AtoCi[c];
+                    const Eigen::Matrix<double,3,1> &p = p_AinCi[c];
+                    Eigen::Matrix<double,3,1> h = R.col(0)*st.alpha + R.col(1)*st.beta + R.col(2) + st.rho*p;
+                    double h3_2 = h(2)*h(2);
+                    Eigen::Matrix<double, 2, 3> H;
+                    H << (R(0, 0) * h(2) - h(0) * R(2, 0)) / h3_2, (R(0, 1) * h(2) - h(0) * R(2, 1)) / h3_2, (p(0) * h(2) - h(0) * p(2)) / h3_2,
+                         (R(1, 0) * h(2) - h(1) * R(2, 0)) / h3_2, (R(1, 1) * h(2) - h(1) * R(2, 1)) / h3_2, (p(1) * h(2) - h(1) * p(2)) / h3_2;
+                    Eigen::Matrix<float, 2, 1> z;
+                    z << h(0) / h(2), h(1) / h(2);
+                    Eigen::Matrix<float, 2, 1> res = uv_norm[c] - z;
+                    st.grad.noalias() += H.transpose() * res.cast<double>();
+                    st.Hess.noalias() += H.transpose() * H;
+                }
+            }
+
+            // Solve Levenberg iteration
+            Eigen::Matrix<double,3,3> Hess_l = st.Hess;
+            for (size_t r=0; r < 3; r++) {
+                Hess_l(r,r) *= (1.0+st.lam);
+            }
+            Eigen::Matrix<double,3,1> dx = Hess_l.colPivHouseholderQr().solve(st.grad);
+
+            // Check if error has gone down
+            double cost = compute_cost(f, st.alpha+dx(0,0), st.beta+dx(1,0), st.rho+dx(2,0));
+
+            // Check if converged
+            if (cost <= st.cost_old && (st.cost_old-cost)/st.cost_old < _options.min_dcost) {
+                st.alpha += dx(0, 0);
+                st.beta += dx(1, 0);
+                st.rho += dx(2, 0);
+                st.eps = 0;
+                st.active = false;
+                continue;
+            }
+
+            // If cost is lowered, accept step
+            // Else inflate lambda (try to make more stable)
+            if (cost <= st.cost_old) {
+                st.recompute = true;
+                st.cost_old = cost;
+                st.alpha += dx(0, 0);
+                st.beta += dx(1, 0);
+                st.rho += dx(2, 0);
+                st.runs++;
+                st.lam = st.lam/_options.lam_mult;
+                st.eps = dx.norm();
+            } else {
+                st.recompute = false;
+                st.lam = st.lam*_options.lam_mult;
+            }
+
+        }
+    }
+
+    //=====================================================================================
+    // FINAL CHECKS
+    //=====================================================================================
+
+    for(size_t f=0; f<num_feats; f++) {
+
+        // Skip if the linear triangulation failed
+        // Else revert to standard, and set to all
+        if(!states[f].triangulated)
+            continue;
+        Feature* feat = feats.at(f);
+        feat->p_FinA(0) = states[f].alpha/states[f].rho;
+        feat->p_FinA(1) = states[f].beta/states[f].rho;
+        feat->p_FinA(2) = 1/states[f].rho;
+
+        // Get tangent plane to x_hat
+        Eigen::HouseholderQR<Eigen::Matrix<double,3,1>> qr(feat->p_FinA);
+        Eigen::Matrix<double,3,3> Q = qr.householderQ();
+
+        // Max baseline we have between poses
+        double base_line_max = 0.0;
+        for(size_t c=meas_start[f]; c<meas_start[f+1]; c++) {
+            double base_line = ((Q.block(0,1,3,2)).transpose() * p_CiinA[c]).norm();
+            if (base_line > base_line_max) base_line_max = base_line;
+        }
+
+        // Check if this feature is bad or not
+        // 1. If the feature is too close
+        // 2. If the feature is invalid
+        // 3. If the baseline ratio is large
+        if(feat->p_FinA(2) < _options.min_dist
+           || feat->p_FinA(2) > _options.max_dist
+           || (feat->p_FinA.norm() / base_line_max) > _options.max_baseline
+           || std::isnan(feat->p_FinA.norm())) {
+            continue;
+        }
+
+        // Finally get position in global frame
+        feat->p_FinG = R_GtoA[f].transpose()*feat->p_FinA + p_AinG[f];
+        success.at(f) = true;
+
+    }
+
+}
@@ -22,6 +22,7 @@
 #define OPEN_VINS_FEATUREINITIALIZER_H
 
 #include <unordered_map>
+#include <vector>
 
 #include "Feature.h"
 #include "FeatureInitializerOptions.h"
@@ -110,6 +111,20 @@ namespace ov_core {
          */
         bool single_gaussnewton(Feature* feat, std::unordered_map<size_t,std::unordered_map<double,ClonePose>> &clonesCAM);
 
+        /**
+         * @brief Triangulates and then refines a whole set of features, same as calling single_triangulation() and single_gaussnewton() on each
+         *
+         * The pose of every measurement relative to the anchor of its feature is found once up front and stored in flat arrays.
+         * The linear triangulation then just accumulates the 3x3 normal equations, and gets the condition number from their eigenvalues.
+         * The Gauss-Newton refinement runs its iterations in lock-step over all features, so each pass streams through these arrays.
+         *
+         * @param feats Features we want to triangulate
+         * @param clonesCAM Map between camera ID to map of timestamp to camera pose estimate (rotation from global to camera, position of camera in global frame)
+         * @param success If each feature was triangulated and refined (will be resized to match the features)
+         */
+        void batch_triangulation(const std::vector<Feature*> &feats, std::unordered_map<size_t,std::unordered_map<double,ClonePose>> &clonesCAM,
+                                 std::vector<char> &success);
+
 
     protected:
 
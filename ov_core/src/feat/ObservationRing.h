@@ -0,0 +1,209 @@
+/*
+ * OpenVINS: An Open Platform for Visual-Inertial Research
+ * Copyright (C) 2019 Patrick Geneva
+ * Copyright (C) 2019 Kevin Eckenhoff
+ * Copyright (C) 2019 Guoquan Huang
+ * Copyright (C) 2019 OpenVINS Contributors
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef OV_CORE_OBSERVATION_RING_H
+#define OV_CORE_OBSERVATION_RING_H
+
+
+#include <vector>
+#include <atomic>
+#include <cstddef>
+
+
+namespace ov_core {
+
+    /**
+     * @brief Lock-free single-producer single-consumer ring of feature observations.
+     *
+     * A tracker (the producer) will push all observations it has for a frame, and then publish them as a single batch.
+     * The estimator (the consumer) will then pop all published observations and insert them into the feature database.
+     * Neither side ever waits on the other, the producer will instead fail to push if the ring is full.
+     * If any observation of a batch does not fit, then the whole batch is dropped on publish() so the consumer never sees a partial frame.
+     * Only one thread should push into a ring, and only one thread (at a time) should pop from it.
+     */
+    class ObservationRing {
+
+    public:
+
+        /**
+         * @brief Single feature observation from a tracker
+         */
+        struct Observation {
+
+            /// ID of the feature
+            size_t id;
+
+            /// Time that this measurement occured at
+            double timestamp;
+
+            /// Which camera this measurement was from
+            size_t cam_id;
+
+            /// Raw uv coordinate
+            float u, v;
+
+            /// Undistorted/normalized uv coordinate
+            float u_n, v_n;
+
+        };
+
+        /**
+         * @brief Default constructor
+         * @param capacity Max number of observations that can be in the ring (will be rounded up to a power of two)
+         */
+        ObservationRing(size_t capacity) {
+            size_t size = 1;
+            while (size < capacity) size *= 2;
+            buffer.resize(size);
+            mask = size - 1;
+        }
+
+        /**
+         * @brief Adds an observation to the current batch (producer only)
+         *
+         * The consumer will not see this observation until publish() has been called.
+         *
+         * @param obs Observation we want to add
+         * @return False if the ring is full and the current batch will be dropped
+         */
+        bool push(const Observation &obs) {
+            if (batch_dropped || staged - tail.load(std::memory_order_acquire) >= buffer.size()) {
+                batch_dropped = true;
+                batch_rejected++;
+                return false;
+            }
+            buffer[staged & mask] = obs;
+            staged++;
+            return true;
+        }
+
+        /**
+         * @brief Adds a set of observations to the current batch, only if all of them fit (producer only)
+         * @param obs Observations we want to add
+         * @return False if the ring is full and the current batch will be dropped
+         */
+        bool push(const std::vector<Observation> &obs) {
+            if (batch_dropped || staged + obs.size() - tail.load(std::memory_order_acquire) > buffer.size()) {
+                batch_dropped = true;
+                batch_rejected += obs.size();
+                return false;
+            }
+            for (const auto &o : obs) {
+                buffer[staged & mask] = o;
+                staged++;
+            }
+            return true;
+        }
+
+        /**
+         * @brief Makes all observations pushed so far visible to the consumer (producer only)
+         *
+         * If any push of this batch has failed, then the whole batch is discarded instead.
+         *
+         * @return Number of observations of this batch that where dropped
+         */
+        size_t publish() {
+            if (batch_dropped) {
+                size_t dropped = batch_rejected + (staged - head.load(std::memory_order_relaxed));
+                staged = head.load(std::memory_order_relaxed);
+                batch_dropped = false;
+                batch_rejected = 0;
+                num_dropped.fetch_add(dropped, std::memory_order_relaxed);
+                return dropped;
+            }
+            head.store(staged, std::memory_order_release);
+            return 0;
+        }
+
+        /// Total number of observations that where dropped since the ring was full (safe to call from any thread)
+        size_t get_num_dropped() const {
+            return num_dropped.load(std::memory_order_relaxed);
+        }
+
+        /**
+         * @brief Pops all published observations (consumer only)
+         * @param func Function that will be called for each observation, in the order they where pushed
+         * @return Number of observations popped
+         */
+        template<typename Func>
+        size_t pop_all(Func func) {
+            size_t t = tail.load(std::memory_order_relaxed);
+            size_t h = head.load(std::memory_order_acquire);
+            for (size_t i = t; i != h; i++) {
+                func(buffer[i & mask]);
+            }
+            tail.store(h, std::memory_order_release);
+            return h - t;
+        }
+
+        /**
+         * @brief Pops published observations up to a given time (consumer only)
+         *
+         * Observations are popped in the order they where pushed, and we stop at the first one that is newer than the requested time.
+         * Since a tracker pushes its frames in time order, this leaves all observations of future frames in the ring.
+         *
+         * @param timestamp Newest measurement time we want to pop
+         * @param func Function that will be called for each observation, in the order they where pushed
+         * @return Number of observations popped
+         */
+        template<typename Func>
+        size_t pop_until(double timestamp, Func func) {
+            size_t t = tail.load(std::memory_order_relaxed);
+            size_t h = head.load(std::memory_order_acquire);
+            size_t i = t;
+            for (; i != h && buffer[i & mask].timestamp <= timestamp; i++) {
+                func(buffer[i & mask]);
+            }
+            tail.store(i, std::memory_order_release);
+            return i - t;
+        }
+
+    protected:
+
+        /// Storage of our observations
+        std::vector<Observation> buffer;
+
+        /// Mask to wrap an index into our buffer (size is a power of two)
+        size_t mask;
+
+        /// Index after the last published observation (written by producer)
+        std::atomic<size_t> head{0};
+
+        /// Index of the oldest observation that has not been popped (written by consumer)
+        std::atomic<size_t> tail{0};
+
+        /// Index after the last pushed observation, this is only used by the producer
+        size_t staged = 0;
+
+        /// If a push of the current batch has failed, this is only used by the producer
+        bool batch_dropped = false;
+
+        /// Number of observations of the current batch that could not be pushed, this is only used by the producer
+        size_t batch_rejected = 0;
+
+        /// Total number of observations dropped on publish
+        std::atomic<size_t> num_dropped{0};
+
+    };
+
+
+}
+
+#endif /* OV_CORE_OBSERVATION_RING_H */
@@ -24,49 +24,27 @@
 using namespace ov_core;
 
 
-void InertialInitializer::feed_imu(double timestamp, Eigen::Matrix<double,3,1> wm, Eigen::Matrix<double,3,1> am) {
-
-    // Create our imu data object
-    IMUDATA data;
-    data.timestamp = timestamp;
-    data.wm = wm;
-    data.am = am;
-
-    // Append it to our vector
-    imu_data.emplace_back(data);
-
-    // Delete all measurements older than three of our initialization windows
-    auto it0 = imu_data.begin();
-    while(it0 != imu_data.end() && it0->timestamp < timestamp-3*_window_length) {
-        it0 = imu_data.erase(it0);
-    }
-
-}
-
-
-
-
-
 bool InertialInitializer::initialize_with_imu(double &time0, Eigen::Matrix<double,4,1> &q_GtoI0, Eigen::Matrix<double,3,1> &b_w0,
                                               Eigen::Matrix<double,3,1> &v_I0inG, Eigen::Matrix<double,3,1> &b_a0, Eigen::Matrix<double,3,1> &p_I0inG, bool wait_for_jerk) {
 
     // Return if we don't have any measurements
-    if(imu_data.empty()) {
+    if(imu_data->empty()) {
         return false;
     }
 
     // Newest imu timestamp
-    double newesttime = imu_data.at(imu_data.size()-1).timestamp;
+    double newesttime = imu_data->back().timestamp;
 
     // First lets collect a window of IMU readings from the newest measurement to the oldest
+    // The window boundaries are found with a binary search, so we only visit the readings inside of them
     std::vector<IMUDATA> window_newest, window_secondnew;
-    for(IMUDATA data : imu_data) {
-        if(data.timestamp > newesttime-1*_window_length && data.timestamp <= newesttime-0*_window_length) {
-            window_newest.push_back(data);
-        }
-        if(data.timestamp > newesttime-2*_window_length && data.timestamp <= newesttime-1*_window_length) {
-            window_secondnew.push_back(data);
-        }
+    size_t i_second = imu_data->upper_bound(newesttime-2*_window_length);
+    size_t i_newest = imu_data->upper_bound(newesttime-1*_window_length);
+    for(size_t i=i_second; i<i_newest; i++) {
+        window_secondnew.push_back(imu_data->at(i));
+    }
+    for(size_t i=i_newest; i<imu_data->size(); i++) {
+        window_newest.push_back(imu_data->at(i));
     }
 
     // Return if both of these failed
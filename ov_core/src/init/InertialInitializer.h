@@ -21,9 +21,11 @@
 #ifndef OV_CORE_INERTIALINITIALIZER_H
 #define OV_CORE_INERTIALINITIALIZER_H
 
+#include <memory>
 #include <Eigen/Eigen>
 #include "utils/quat_ops.h"
 #include "utils/colors.h"
+#include "utils/ImuBuffer.h"
 
 namespace ov_core {
 
@@ -48,21 +50,8 @@ namespace ov_core {
 
     public:
 
-        /**
-         * @brief Struct for a single imu measurement (time, wm, am)
-         */
-        struct IMUDATA {
-
-            /// Timestamp of the reading
-            double timestamp;
-
-            /// Gyroscope reading, angular velocity (rad/s)
-            Eigen::Matrix<double, 3, 1> wm;
-
-            /// Accelerometer reading, linear acceleration (m/s^2)
-            Eigen::Matrix<double, 3, 1> am;
-
-        };
+        /// Struct for a single imu measurement (time, wm, am)
+        typedef ImuBuffer::IMUDATA IMUDATA;
 
 
         /**
@@ -70,19 +59,10 @@ namespace ov_core {
          * @param gravity Gravity in the global frame of reference
          * @param window_length Amount of time we will initialize over (seconds)
          * @param imu_excite_threshold Variance threshold on our acceleration to be classified as moving
+         * @param imu_data History of IMU messages we will read from (should cover at least two windows)
          */
-        InertialInitializer(Eigen::Matrix<double,3,1> gravity, double window_length, double imu_excite_threshold) :
-                            _gravity(gravity), _window_length(window_length), _imu_excite_threshold(imu_excite_threshold) {}
-
-
-        /**
-         * @brief Stores incoming inertial readings
-         *
-         * @param timestamp Timestamp of imu reading
-         * @param wm Gyro angular velocity reading
-         * @param am Accelerometer linear acceleration reading
-         */
-        void feed_imu(double timestamp, Eigen::Matrix<double,3,1> wm, Eigen::Matrix<double,3,1> am);
+        InertialInitializer(Eigen::Matrix<double,3,1> gravity, double window_length, double imu_excite_threshold, std::shared_ptr<ImuBuffer> imu_data) :
+                            _gravity(gravity), _window_length(window_length), _imu_excite_threshold(imu_excite_threshold), imu_data(imu_data) {}
 
 
         /**
@@ -120,8 +100,8 @@ namespace ov_core {
         /// Variance threshold on our acceleration to be classified as moving
         double _imu_excite_threshold;
 
-        /// Our history of IMU messages (time, angular, linear)
-        std::vector<IMUDATA> imu_data;
+        /// Our history of IMU messages (time, angular, linear), this is shared with the propagator
+        std::shared_ptr<ImuBuffer> imu_data;
 
 
     };
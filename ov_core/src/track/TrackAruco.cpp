@@ -87,22 +87,27 @@ void TrackAruco::feed_monocular(double timestamp, cv::Mat &imgin, size_t cam_id)
     // ID vectors, of all currently tracked IDs
     std::vector<size_t> ids_new;
 
-    // Append to our feature database this new information
+    // Collect the first corner of each tag we want to use
+    std::vector<cv::Point2f> pts_new, npts_new;
     for(size_t i=0; i<ids_aruco[cam_id].size(); i++) {
         // Skip if ID is greater then our max
         if(ids_aruco[cam_id].at(i) > max_tag_id)
             continue;
         // Assert we have 4 points (we will only use one of them)
         assert(corners[cam_id].at(i).size()==4);
-        // Try to undistort the point
-        cv::Point2f npt_l = undistort_point(corners[cam_id].at(i).at(0), cam_id);
-        // Append to the ids vector and database
         ids_new.push_back((size_t)ids_aruco[cam_id].at(i));
-        database->update_feature((size_t)ids_aruco[cam_id].at(i), timestamp, cam_id,
-                                 corners[cam_id].at(i).at(0).x, corners[cam_id].at(i).at(0).y,
-                                 npt_l.x, npt_l.y);
+        pts_new.push_back(corners[cam_id].at(i).at(0));
     }
 
+    // Undistort them all at once, and append to our feature database
+    undistort_points(pts_new, cam_id, npts_new);
+    std::vector<ObservationRing::Observation> obs_new;
+    for(size_t i=0; i<ids_new.size(); i++) {
+        obs_new.push_back({ids_new.at(i), timestamp, cam_id, pts_new.at(i).x, pts_new.at(i).y, npts_new.at(i).x, npts_new.at(i).y});
+    }
+    database->update_features(obs_new);
+    database->publish_observations(cam_id);
+
 
     // Move forward in time
     img_last[cam_id] = img.clone();
@@ -200,20 +205,16 @@ void TrackAruco::feed_stereo(double timestamp, cv::Mat &img_leftin, cv::Mat &img
     // ID vectors, of all currently tracked IDs
     std::vector<size_t> ids_left_new, ids_right_new;
 
-    // Append to our feature database this new information
+    // Collect the first corner of each tag we want to use
+    std::vector<cv::Point2f> pts_left, pts_right, npts_left, npts_right;
     for(size_t i=0; i<ids_aruco[cam_id_left].size(); i++) {
         // Skip if ID is greater then our max
         if(ids_aruco[cam_id_left].at(i) > max_tag_id)
             continue;
         // Assert we have 4 points (we will only use one of them)
         assert(corners[cam_id_left].at(i).size()==4);
-        // Try to undistort the point (could fail undistortion!)
-        cv::Point2f npt_l = undistort_point(corners[cam_id_left].at(i).at(0), cam_id_left);
-        // Append to the ids vector and database
         ids_left_new.push_back((size_t)ids_aruco[cam_id_left].at(i));
-        database->update_feature((size_t)ids_aruco[cam_id_left].at(i), timestamp, cam_id_left,
-                                 corners[cam_id_left].at(i).at(0).x, corners[cam_id_left].at(i).at(0).y,
-                                 npt_l.x, npt_l.y);
+        pts_left.push_back(corners[cam_id_left].at(i).at(0));
     }
     for(size_t i=0; i<ids_aruco[cam_id_right].size(); i++) {
         // Skip if ID is greater then our max
@@ -221,14 +222,24 @@ void TrackAruco::feed_stereo(double timestamp, cv::Mat &img_leftin, cv::Mat &img
             continue;
         // Assert we have 4 points (we will only use one of them)
         assert(corners[cam_id_right].at(i).size()==4);
-        // Try to undistort the point (could fail undistortion!)
-        cv::Point2f npt_l = undistort_point(corners[cam_id_right].at(i).at(0), cam_id_right);
-        // Append to the ids vector and database
         ids_right_new.push_back((size_t)ids_aruco[cam_id_right].at(i));
-        database->update_feature((size_t)ids_aruco[cam_id_right].at(i), timestamp, cam_id_right,
-                                 corners[cam_id_right].at(i).at(0).x, corners[cam_id_right].at(i).at(0).y,
-                                 npt_l.x, npt_l.y);
+        pts_right.push_back(corners[cam_id_right].at(i).at(0));
+    }
+
+    // Undistort them all at once (could fail undistortion!), and append to our feature database
+    undistort_points(pts_left, cam_id_left, npts_left);
+    undistort_points(pts_right, cam_id_right, npts_right);
+    std::vector<ObservationRing::Observation> obs_left, obs_right;
+    for(size_t i=0; i<ids_left_new.size(); i++) {
+        obs_left.push_back({ids_left_new.at(i), timestamp, cam_id_left, pts_left.at(i).x, pts_left.at(i).y, npts_left.at(i).x, npts_left.at(i).y});
+    }
+    for(size_t i=0; i<ids_right_new.size(); i++) {
+        obs_right.push_back({ids_right_new.at(i), timestamp, cam_id_right, pts_right.at(i).x, pts_right.at(i).y, npts_right.at(i).x, npts_right.at(i).y});
     }
+    database->update_features(obs_left);
+    database->update_features(obs_right);
+    database->publish_observations(cam_id_left);
+    database->publish_observations(cam_id_right);
 
 
     // Move forward in time
@@ -89,6 +89,17 @@ namespace ov_core {
 
     protected:
 
+        /**
+         * @brief Creates the per-camera storage (including our tag detections) for a camera
+         * @param cam_id camera id we want to create storage for
+         */
+        void init_camera_storage(size_t cam_id) override {
+            TrackBase::init_camera_storage(cam_id);
+            ids_aruco[cam_id];
+            corners[cam_id];
+            rejects[cam_id];
+        }
+
         // Timing variables
         boost::posix_time::ptime rT1, rT2, rT3, rT4, rT5, rT6, rT7;
 
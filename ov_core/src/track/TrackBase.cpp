@@ -142,7 +142,9 @@ void TrackBase::display_history(cv::Mat &img_out, int r1, int g1, int b1, int r2
                 if(feat->uvs[pair.first].size()-z > maxtracks)
                     break;
                 // Calculate what color we are drawing in
-                bool is_stereo = (feat->uvs.size() > 1);
+                // Note that recycled features can have empty measurement arrays for cameras they are not seen in
+                bool is_stereo = (std::count_if(feat->uvs.begin(), feat->uvs.end(),
+                        [](const std::pair<const size_t, std::vector<Eigen::Vector2f>> &cam) { return !cam.second.empty(); }) > 1);
                 int color_r = (is_stereo? b2 : r2)-(int)((is_stereo? b1 : r1)/feat->uvs[pair.first].size()*z);
                 int color_g = (is_stereo? r2 : g2)-(int)((is_stereo? r1 : g1)/feat->uvs[pair.first].size()*z);
                 int color_b = (is_stereo? g2 : b2)-(int)((is_stereo? g1 : b1)/feat->uvs[pair.first].size()*z);
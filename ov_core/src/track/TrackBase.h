@@ -26,6 +26,7 @@
 #include <thread>
 #include <mutex>
 #include <atomic>
+#include <map>
 #include <unordered_map>
 #include <Eigen/StdVector>
 
@@ -36,8 +37,10 @@
 
 #include "Grider_FAST.h"
 #include "Grider_DOG.h"
+#include "UndistortLUT.h"
 #include "feat/FeatureDatabase.h"
 #include "utils/colors.h"
+#include "utils/TaskPool.h"
 
 
 namespace ov_core {
@@ -51,7 +54,7 @@ namespace ov_core {
      * We have something called the "feature database" which has all the tracking information inside of it.
      * The user can ask this database for features which can then be used in an MSCKF or batch-based setting.
      * The feature tracks store both the raw (distorted) and undistorted/normalized values.
-     * Right now we just support two camera models, see: undistort_point_brown() and undistort_point_fisheye().
+     * Right now we just support two camera models, see: undistort_points_brown() and undistort_points_fisheye().
      *
      * @m_class{m-note m-warning}
      *
@@ -62,6 +65,8 @@ namespace ov_core {
      * The @ref currid is atomic to allow for multiple threads to access it without issue and ensure that all features have unique id values.
      * We also have mutex for access for the calibration and previous images and tracks (used during visualization).
      * It should be noted that if a thread calls visualization, it might hang or the feed thread might, due to acquiring the mutex for that specific camera id / feed.
+     * Work that is done in parallel inside of a tracker (e.g. both images of a stereo pair) is given to a persistent @ref TaskPool.
+     * By default each tracker has its own pool with a single worker, but a shared pool can be given with set_task_pool().
      *
      * This base class also handles most of the heavy lifting with the visualization, but the sub-classes can override
      * this and do their own logic if they want (i.e. the TrackAruco has its own logic for visualization).
@@ -75,14 +80,14 @@ namespace ov_core {
         /**
          * @brief Public default constructor
          */
-        TrackBase() : database(new FeatureDatabase()), num_features(200), currid(0) { }
+        TrackBase() : database(new FeatureDatabase()), pool(new TaskPool(1)), num_features(200), currid(0) { }
 
         /**
          * @brief Public constructor with configuration variables
          * @param numfeats number of features we want want to track (i.e. track 200 points from frame to frame)
          * @param numaruco the max id of the arucotags, so we ensure that we start our non-auroc features above this value
          */
-        TrackBase(int numfeats, int numaruco) : database(new FeatureDatabase()), num_features(numfeats) {
+        TrackBase(int numfeats, int numaruco) : database(new FeatureDatabase()), pool(new TaskPool(1)), num_features(numfeats) {
             // Our current feature ID should be larger then the number of aruco tags we have
             currid = (size_t) numaruco + 1;
         }
@@ -143,6 +148,7 @@ namespace ov_core {
             assert(camera_k_OPENCV.size()==camera_fisheye.size());
 
             // Convert values to the OpenCV format
+            std::vector<size_t> cams_changed;
             for (auto const &cam : camera_calib) {
                 // Lock this image feed
                 std::unique_lock<std::mutex> lck(mtx_feeds.at(cam.first));
@@ -169,29 +175,44 @@ namespace ov_core {
                 tempD(2) = cam.second(6);
                 tempD(3) = cam.second(7);
                 camera_d_OPENCV.at(cam.first) = tempD;
+                // Rebuild the lookup table if the calibration moved too far
+                if(update_lut(cam.first))
+                    cams_changed.push_back(cam.first);
             }
 
             // If we are calibrating camera intrinsics our normalize coordinates will be stale
             // This is because we appended them to the database with the current best guess *at that timestep*
             // Thus here since we have a change in calibration, re-normalize all the features we have
-            if(correct_active) {
+            // If we use lookup tables, only the cameras that had their table rebuilt will have changed
+            if(correct_active && !cams_changed.empty()) {
 
                 // Get all features in this database
                 std::unordered_map<size_t, Feature*> features_idlookup = database->get_internal_data();
 
-                // Loop through and correct each one
-                for(const auto& pair_feat : features_idlookup) {
-                    // Get our feature
-                    Feature *feat = pair_feat.second;
-                    // Loop through each camera for this feature
-                    for (auto const& meas_pair : feat->timestamps) {
-                        size_t camid = meas_pair.first;
-                        std::unique_lock<std::mutex> lck(mtx_feeds.at(camid));
-                        for(size_t m=0; m<feat->uvs.at(camid).size(); m++) {
-                            cv::Point2f pt(feat->uvs.at(camid).at(m)(0), feat->uvs.at(camid).at(m)(1));
-                            cv::Point2f pt_n = undistort_point(pt,camid);
-                            feat->uvs_norm.at(camid).at(m)(0) = pt_n.x;
-                            feat->uvs_norm.at(camid).at(m)(1) = pt_n.y;
+                // Correct each camera in a single pass over all its measurements
+                for(const auto &camid : cams_changed) {
+                    std::unique_lock<std::mutex> lck(mtx_feeds.at(camid));
+                    // Gather all measurements of this camera into one flat buffer
+                    std::vector<cv::Point2f> pts, pts_n;
+                    for(const auto& pair_feat : features_idlookup) {
+                        auto it = pair_feat.second->uvs.find(camid);
+                        if(it == pair_feat.second->uvs.end())
+                            continue;
+                        for(const auto &uv : it->second) {
+                            pts.emplace_back(uv(0), uv(1));
+                        }
+                    }
+                    // Undistort them all, and write them back in the same order
+                    undistort_points(pts, camid, pts_n);
+                    size_t idx = 0;
+                    for(const auto& pair_feat : features_idlookup) {
+                        auto it = pair_feat.second->uvs_norm.find(camid);
+                        if(it == pair_feat.second->uvs_norm.end())
+                            continue;
+                        for(auto &uv_n : it->second) {
+                            uv_n(0) = pts_n.at(idx).x;
+                            uv_n(1) = pts_n.at(idx).y;
+                            idx++;
                         }
                     }
                 }
@@ -219,6 +240,65 @@ namespace ov_core {
          */
         virtual void feed_stereo(double timestamp, cv::Mat &img_left, cv::Mat &img_right, size_t cam_id_left, size_t cam_id_right) = 0;
 
+        /**
+         * @brief Process a synchronized set of images from any number of cameras
+         *
+         * Each stereo pair is tracked with feed_stereo(), and all other cameras are tracked with feed_monocular().
+         * All of these are run in parallel on our task pool, and we return once every camera has been tracked.
+         *
+         * @param timestamp timestamp this set of images occured at (all cameras are synchronised)
+         * @param imgs grayscaled images, one for each camera
+         * @param cam_ids camera id of each image
+         * @param stereo_pairs pairs of camera ids (left, right) that should be tracked as stereo
+         */
+        virtual void feed_multi(double timestamp, std::vector<cv::Mat> &imgs, const std::vector<size_t> &cam_ids,
+                                const std::vector<std::pair<size_t,size_t>> &stereo_pairs = std::vector<std::pair<size_t,size_t>>()) {
+
+            // Assert we have an id for each image
+            assert(imgs.size()==cam_ids.size());
+
+            // Create the storage of all cameras before we start, so our threads never insert into a shared map
+            for(const auto &cam_id : cam_ids) {
+                init_camera_storage(cam_id);
+            }
+
+            // Find the index of each camera id
+            std::map<size_t, size_t> cam_index;
+            for(size_t i=0; i<cam_ids.size(); i++) {
+                cam_index.insert({cam_ids.at(i), i});
+            }
+
+            // Stereo pairs first, each camera can only be part of a single pair
+            std::vector<TaskPool::Task> tasks;
+            std::vector<bool> is_paired(cam_ids.size(), false);
+            for(const auto &pair : stereo_pairs) {
+                if(cam_index.find(pair.first)==cam_index.end() || cam_index.find(pair.second)==cam_index.end())
+                    continue;
+                size_t idx_l = cam_index.at(pair.first);
+                size_t idx_r = cam_index.at(pair.second);
+                if(idx_l==idx_r || is_paired.at(idx_l) || is_paired.at(idx_r))
+                    continue;
+                is_paired.at(idx_l) = true;
+                is_paired.at(idx_r) = true;
+                tasks.push_back({"track_stereo", [this, timestamp, &imgs, &cam_ids, idx_l, idx_r] {
+                    feed_stereo(timestamp, imgs.at(idx_l), imgs.at(idx_r), cam_ids.at(idx_l), cam_ids.at(idx_r));
+                }});
+            }
+
+            // All other cameras are tracked by themselves
+            for(size_t i=0; i<cam_ids.size(); i++) {
+                if(is_paired.at(i))
+                    continue;
+                tasks.push_back({"track_monocular", [this, timestamp, &imgs, &cam_ids, i] {
+                    feed_monocular(timestamp, imgs.at(i), cam_ids.at(i));
+                }});
+            }
+
+            // Finally track all cameras in parallel
+            pool->run(tasks);
+
+        }
+
         /**
          * @brief Shows features extracted in the last image
          * @param img_out image to which we will overlayed features on
@@ -243,6 +323,23 @@ namespace ov_core {
             return database;
         }
 
+        /**
+         * @brief Sets the pool of threads this tracker will give its parallel work to
+         *
+         * This allows for all trackers and the manager to share a single set of threads.
+         * Should not be called while we are tracking.
+         *
+         * @param taskpool Pool that we should use
+         */
+        void set_task_pool(std::shared_ptr<TaskPool> taskpool) {
+            pool = taskpool;
+        }
+
+        /// Returns the pool of threads we give our parallel work to
+        std::shared_ptr<TaskPool> get_task_pool() {
+            return pool;
+        }
+
         /**
          * @brief Changes the ID of an actively tracked feature to another one
          * @param id_old Old id we want to change
@@ -281,65 +378,239 @@ namespace ov_core {
          * In Kalibr's terms, the non-fisheye is `pinhole-radtan` while the fisheye is the `pinhole-equi` model.
          */
         cv::Point2f undistort_point(cv::Point2f pt_in, size_t cam_id) {
+            std::vector<cv::Point2f> pts_out;
+            undistort_points(std::vector<cv::Point2f>{pt_in}, cam_id, pts_out);
+            return pts_out.at(0);
+        }
+
+        /**
+         * @brief Undistort/normalize a set of points from the same camera in a single pass.
+         * @param pts_in uv 2x1 points that we will undistort
+         * @param cam_id id of which camera these points are in
+         * @param pts_out undistorted 2x1 points (will be resized to match the input)
+         *
+         * This should be used instead of undistort_point() whenever we have more than one point.
+         * The camera parameters are only looked up once, and the iterations of all points are done together in tight loops.
+         * If set_undistort_lut() has been called, points are instead interpolated from the lookup table of this camera.
+         */
+        void undistort_points(const std::vector<cv::Point2f> &pts_in, size_t cam_id, std::vector<cv::Point2f> &pts_out) {
             // Determine what camera parameters we should use
-            cv::Matx33d camK = this->camera_k_OPENCV.at(cam_id);
-            cv::Vec4d camD = this->camera_d_OPENCV.at(cam_id);
-            // Call on the fisheye if we should!
-            if (this->camera_fisheye.at(cam_id)) {
-                return undistort_point_fisheye(pt_in, camK, camD);
+            const cv::Matx33d &camK = this->camera_k_OPENCV.at(cam_id);
+            const cv::Vec4d &camD = this->camera_d_OPENCV.at(cam_id);
+            // Use our lookup table if we have one, only points outside of it need to be undistorted exactly
+            auto it = camera_lut.find(cam_id);
+            if (it != camera_lut.end()) {
+                std::vector<size_t> outside;
+                it->second.lookup(pts_in, pts_out, outside);
+                if (outside.empty())
+                    return;
+                std::vector<cv::Point2f> pts_outside, pts_outside_n;
+                for (const auto &idx : outside)
+                    pts_outside.push_back(pts_in.at(idx));
+                undistort_points_model(pts_outside, camK, camD, this->camera_fisheye.at(cam_id), pts_outside_n);
+                for (size_t i = 0; i < outside.size(); i++)
+                    pts_out.at(outside.at(i)) = pts_outside_n.at(i);
+                return;
+            }
+            // Else directly undistort them
+            undistort_points_model(pts_in, camK, camD, this->camera_fisheye.at(cam_id), pts_out);
+        }
+
+        /**
+         * @brief Re-normalizes the raw uv of observations from a single camera with our current calibration
+         * @param obs Observations of the same camera, their normalized coordinates will be overwritten
+         *
+         * This is used when observations waited in an observation ring while our calibration was changed.
+         * They are then normalized exactly as if they had been tracked with the calibration we have now.
+         */
+        void normalize_observations(std::vector<ObservationRing::Observation> &obs) {
+            if (obs.empty())
+                return;
+            size_t cam_id = obs.at(0).cam_id;
+            std::unique_lock<std::mutex> lck(mtx_feeds.at(cam_id));
+            std::vector<cv::Point2f> pts, pts_n;
+            for (const auto &o : obs) {
+                assert(o.cam_id == cam_id);
+                pts.emplace_back(o.u, o.v);
+            }
+            undistort_points(pts, cam_id, pts_n);
+            for (size_t i = 0; i < obs.size(); i++) {
+                obs.at(i).u_n = pts_n.at(i).x;
+                obs.at(i).v_n = pts_n.at(i).y;
+            }
+        }
+
+        /**
+         * @brief Will use a lookup table to undistort the points of each camera instead of iterating the camera model.
+         * @param camera_wh Width and height of the images of each camera (cameras not in here will not use a table)
+         * @param step Spacing of the table grid in pixels
+         * @param tolerance How far in pixels the calibration can move before a table is rebuilt and the database is re-normalized
+         *                  (non-positive to use the interpolation error of each table, as a smaller change would not make it more accurate)
+         *
+         * This needs to be called after set_calibration() and before we start tracking.
+         * With online intrinsic calibration, this means that we only need to re-normalize the database when a table is rebuilt.
+         */
+        void set_undistort_lut(const std::map<size_t,std::pair<int,int>> &camera_wh, int step, double tolerance) {
+            lut_wh = camera_wh;
+            lut_step = step;
+            lut_tolerance = tolerance;
+            camera_lut.clear();
+            for (auto const &cam : camera_k_OPENCV) {
+                if (lut_wh.find(cam.first) == lut_wh.end())
+                    continue;
+                camera_lut[cam.first];
+                std::unique_lock<std::mutex> lck(mtx_feeds.at(cam.first));
+                update_lut(cam.first);
             }
-            return undistort_point_brown(pt_in, camK, camD);
         }
 
     protected:
 
+        /**
+         * @brief Rebuilds the lookup table of a camera if its calibration has moved past our tolerance (mutex should be locked)
+         * @param cam_id camera id we want to update the table of
+         * @return True if the normalized coordinates of this camera have changed (always true if it has no table)
+         */
+        bool update_lut(size_t cam_id) {
+            auto it = camera_lut.find(cam_id);
+            if (it == camera_lut.end())
+                return true;
+            const cv::Matx33d &camK = this->camera_k_OPENCV.at(cam_id);
+            const cv::Vec4d &camD = this->camera_d_OPENCV.at(cam_id);
+            bool fisheye = this->camera_fisheye.at(cam_id);
+            if (it->second.is_valid(camK, camD, fisheye, lut_tolerance))
+                return false;
+            auto wh = lut_wh.at(cam_id);
+            it->second.build(wh.first, wh.second, lut_step, camK, camD, fisheye,
+                             [fisheye](const std::vector<cv::Point2f> &pts_in, const cv::Matx33d &K, const cv::Vec4d &D, std::vector<cv::Point2f> &pts_out) {
+                                 undistort_points_model(pts_in, K, D, fisheye, pts_out);
+                             });
+            return true;
+        }
+
+        /**
+         * @brief Creates the per-camera storage for a camera if it does not exist yet
+         *
+         * Trackers that have their own per-camera maps should override this, and also call this base function.
+         * This is called before cameras are tracked in parallel, as inserting into a map is not thread safe.
+         *
+         * @param cam_id camera id we want to create storage for
+         */
+        virtual void init_camera_storage(size_t cam_id) {
+            img_last[cam_id];
+            pts_last[cam_id];
+            ids_last[cam_id];
+        }
+
+        /**
+         * @brief Exactly undistorts points with the radtan or fisheye model
+         * @param pts_in uv 2x1 points that we will undistort
+         * @param camK Camera intrinsic matrix
+         * @param camD Camera distortion parameters
+         * @param fisheye If we should use the fisheye model
+         * @param pts_out undistorted 2x1 points
+         */
+        static void undistort_points_model(const std::vector<cv::Point2f> &pts_in, const cv::Matx33d &camK, const cv::Vec4d &camD, bool fisheye,
+                                           std::vector<cv::Point2f> &pts_out) {
+            if (fisheye) {
+                undistort_points_fisheye(pts_in, camK, camD, pts_out);
+            } else {
+                undistort_points_brown(pts_in, camK, camD, pts_out);
+            }
+        }
+
         /**
          * @brief Undistort function RADTAN/BROWN.
          *
-         * Given a uv point, this will undistort it based on the camera matrices.
+         * Given uv points, this will undistort them based on the camera matrices.
          * To equate this to Kalibr's models, this is what you would use for `pinhole-radtan`.
+         * This uses the same fixed-point iteration as cv::undistortPoints() (five iterations), but all points are iterated together.
+         * Each iteration is a branch free loop over flat arrays, which allows the compiler to vectorize it.
          */
-        cv::Point2f undistort_point_brown(cv::Point2f pt_in, cv::Matx33d &camK, cv::Vec4d &camD) {
-            // Convert to opencv format
-            cv::Mat mat(1, 2, CV_32F);
-            mat.at<float>(0, 0) = pt_in.x;
-            mat.at<float>(0, 1) = pt_in.y;
-            mat = mat.reshape(2); // Nx1, 2-channel
-            // Undistort it!
-            cv::undistortPoints(mat, mat, camK, camD);
-            // Construct our return vector
-            cv::Point2f pt_out;
-            mat = mat.reshape(1); // Nx2, 1-channel
-            pt_out.x = mat.at<float>(0, 0);
-            pt_out.y = mat.at<float>(0, 1);
-            return pt_out;
+        static void undistort_points_brown(const std::vector<cv::Point2f> &pts_in, const cv::Matx33d &camK, const cv::Vec4d &camD,
+                                           std::vector<cv::Point2f> &pts_out) {
+            // Our camera parameters
+            const size_t n = pts_in.size();
+            const double ifx = 1.0 / camK(0, 0), ify = 1.0 / camK(1, 1);
+            const double cx = camK(0, 2), cy = camK(1, 2);
+            const double k1 = camD(0), k2 = camD(1), p1 = camD(2), p2 = camD(3);
+            // Normalize the distorted points, this is our initial guess
+            std::vector<double> x0(n), y0(n), x(n), y(n);
+            std::vector<char> invalid(n, 0);
+            for (size_t i = 0; i < n; i++) {
+                x0[i] = (pts_in[i].x - cx) * ifx;
+                y0[i] = (pts_in[i].y - cy) * ify;
+                x[i] = x0[i];
+                y[i] = y0[i];
+            }
+            // Iteratively remove the distortion
+            for (int iter = 0; iter < 5; iter++) {
+                for (size_t i = 0; i < n; i++) {
+                    double r2 = x[i] * x[i] + y[i] * y[i];
+                    double cdist = 1 + (k2 * r2 + k1) * r2;
+                    double dx = 2 * p1 * x[i] * y[i] + p2 * (r2 + 2 * x[i] * x[i]);
+                    double dy = p1 * (r2 + 2 * y[i] * y[i]) + 2 * p2 * x[i] * y[i];
+                    invalid[i] |= (cdist <= 0);
+                    x[i] = (x0[i] - dx) / cdist;
+                    y[i] = (y0[i] - dy) / cdist;
+                }
+            }
+            // Construct our return vector (if the distortion was not invertible we return the normalized distorted point)
+            pts_out.resize(n);
+            for (size_t i = 0; i < n; i++) {
+                pts_out[i].x = (float) (invalid[i] ? x0[i] : x[i]);
+                pts_out[i].y = (float) (invalid[i] ? y0[i] : y[i]);
+            }
         }
 
         /**
          * @brief Undistort function FISHEYE/EQUIDISTANT.
          *
-         * Given a uv point, this will undistort it based on the camera matrices.
+         * Given uv points, this will undistort them based on the camera matrices.
          * To equate this to Kalibr's models, this is what you would use for `pinhole-equi`.
+         * We find the undistorted angle of each point with Newton iterations on theta_d = theta*(1 + k1*theta^2 + ... + k4*theta^8).
+         * As with the radtan model, all points are iterated together in branch free loops over flat arrays.
          */
-        cv::Point2f undistort_point_fisheye(cv::Point2f pt_in, cv::Matx33d &camK, cv::Vec4d &camD) {
-            // Convert point to opencv format
-            cv::Mat mat(1, 2, CV_32F);
-            mat.at<float>(0, 0) = pt_in.x;
-            mat.at<float>(0, 1) = pt_in.y;
-            mat = mat.reshape(2); // Nx1, 2-channel
-            // Undistort it!
-            cv::fisheye::undistortPoints(mat, mat, camK, camD);
-            // Construct our return vector
-            cv::Point2f pt_out;
-            mat = mat.reshape(1); // Nx2, 1-channel
-            pt_out.x = mat.at<float>(0, 0);
-            pt_out.y = mat.at<float>(0, 1);
-            return pt_out;
+        static void undistort_points_fisheye(const std::vector<cv::Point2f> &pts_in, const cv::Matx33d &camK, const cv::Vec4d &camD,
+                                             std::vector<cv::Point2f> &pts_out) {
+            // Our camera parameters
+            const size_t n = pts_in.size();
+            const double ifx = 1.0 / camK(0, 0), ify = 1.0 / camK(1, 1);
+            const double cx = camK(0, 2), cy = camK(1, 2);
+            const double k1 = camD(0), k2 = camD(1), k3 = camD(2), k4 = camD(3);
+            // Normalize the distorted points, and get their distorted angle
+            std::vector<double> xd(n), yd(n), theta_d(n), theta(n);
+            for (size_t i = 0; i < n; i++) {
+                xd[i] = (pts_in[i].x - cx) * ifx;
+                yd[i] = (pts_in[i].y - cy) * ify;
+                theta_d[i] = std::min(std::sqrt(xd[i] * xd[i] + yd[i] * yd[i]), M_PI / 2.0);
+                theta[i] = theta_d[i];
+            }
+            // Newton iterations to find the undistorted angle
+            for (int iter = 0; iter < 10; iter++) {
+                for (size_t i = 0; i < n; i++) {
+                    double t2 = theta[i] * theta[i];
+                    double t4 = t2 * t2, t6 = t4 * t2, t8 = t6 * t2;
+                    double f = theta[i] * (1 + k1 * t2 + k2 * t4 + k3 * t6 + k4 * t8) - theta_d[i];
+                    double df = 1 + 3 * k1 * t2 + 5 * k2 * t4 + 7 * k3 * t6 + 9 * k4 * t8;
+                    theta[i] -= f / df;
+                }
+            }
+            // Construct our return vector (points at the center have no distortion)
+            pts_out.resize(n);
+            for (size_t i = 0; i < n; i++) {
+                double scale = (theta_d[i] > 1e-8) ? std::tan(theta[i]) / theta_d[i] : 1.0;
+                pts_out[i].x = (float) (xd[i] * scale);
+                pts_out[i].y = (float) (yd[i] * scale);
+            }
         }
 
         /// Database with all our current features
         FeatureDatabase *database;
 
+        /// Pool of threads we give our parallel work to
+        std::shared_ptr<TaskPool> pool;
+
         /// If we are a fisheye model or not
         std::map<size_t, bool> camera_fisheye;
 
@@ -349,6 +620,18 @@ namespace ov_core {
         /// Camera distortion in OpenCV format
         std::map<size_t, cv::Vec4d> camera_d_OPENCV;
 
+        /// Undistortion lookup table for each camera (empty if we undistort exactly)
+        std::map<size_t, UndistortLUT> camera_lut;
+
+        /// Image width and height each lookup table covers
+        std::map<size_t, std::pair<int,int>> lut_wh;
+
+        /// Spacing of the lookup table grids in pixels
+        int lut_step = 4;
+
+        /// How far in pixels the calibration can move before a lookup table is rebuilt (non-positive to use its interpolation error)
+        double lut_tolerance = 0;
+
         /// Number of features we should try to track frame to frame
         int num_features;
 
@@ -111,12 +111,15 @@ void TrackDescriptor::feed_monocular(double timestamp, cv::Mat &imgin, size_t ca
 
 
     // Update our feature database, with theses new observations
+    std::vector<cv::Point2f> pts_left, npts_left;
+    cv::KeyPoint::convert(good_left, pts_left);
+    undistort_points(pts_left, cam_id, npts_left);
+    std::vector<ObservationRing::Observation> obs_left;
     for(size_t i=0; i<good_left.size(); i++) {
-        cv::Point2f npt_l = undistort_point(good_left.at(i).pt, cam_id);
-        database->update_feature(good_ids_left.at(i), timestamp, cam_id,
-                                 good_left.at(i).pt.x, good_left.at(i).pt.y,
-                                 npt_l.x, npt_l.y);
+        obs_left.push_back({good_ids_left.at(i), timestamp, cam_id, pts_left.at(i).x, pts_left.at(i).y, npts_left.at(i).x, npts_left.at(i).y});
     }
+    database->update_features(obs_left);
+    database->publish_observations(cam_id);
 
     // Debug info
     //printf("LtoL = %d | good = %d | fromlast = %d\n",(int)matches_ll.size(),(int)good_left.size(),num_tracklast);
@@ -183,15 +186,15 @@ void TrackDescriptor::feed_stereo(double timestamp, cv::Mat &img_leftin, cv::Mat
     // Our matches temporally
     std::vector<cv::DMatch> matches_ll, matches_rr;
 
-    // Lets match temporally
-    boost::thread t_ll = boost::thread(&TrackDescriptor::robust_match, this, boost::ref(pts_last[cam_id_left]), boost::ref(pts_left_new),
-                                       boost::ref(desc_last[cam_id_left]), boost::ref(desc_left_new), cam_id_left, cam_id_left, boost::ref(matches_ll));
-    boost::thread t_rr = boost::thread(&TrackDescriptor::robust_match, this, boost::ref(pts_last[cam_id_right]), boost::ref(pts_right_new),
-                                       boost::ref(desc_last[cam_id_right]), boost::ref(desc_right_new), cam_id_right, cam_id_right, boost::ref(matches_rr));
-
-    // Wait till both threads finish
-    t_ll.join();
-    t_rr.join();
+    // Lets match temporally, and wait till both are done
+    pool->run({
+        {"desc_matching", [&] {
+            robust_match(pts_last[cam_id_left], pts_left_new, desc_last[cam_id_left], desc_left_new, cam_id_left, cam_id_left, matches_ll);
+        }},
+        {"desc_matching", [&] {
+            robust_match(pts_last[cam_id_right], pts_right_new, desc_last[cam_id_right], desc_right_new, cam_id_right, cam_id_right, matches_rr);
+        }}
+    });
     rT3 =  boost::posix_time::microsec_clock::local_time();
 
 
@@ -261,20 +264,23 @@ void TrackDescriptor::feed_stereo(double timestamp, cv::Mat &img_leftin, cv::Mat
 
 
     // Update our feature database, with theses new observations
+    std::vector<cv::Point2f> pts_left, pts_right, npts_left, npts_right;
+    cv::KeyPoint::convert(good_left, pts_left);
+    cv::KeyPoint::convert(good_right, pts_right);
+    undistort_points(pts_left, cam_id_left, npts_left);
+    undistort_points(pts_right, cam_id_right, npts_right);
+    std::vector<ObservationRing::Observation> obs_left, obs_right;
     for(size_t i=0; i<good_left.size(); i++) {
         // Assert that our IDs are the same
         assert(good_ids_left.at(i)==good_ids_right.at(i));
-        // Try to undistort the point
-        cv::Point2f npt_l = undistort_point(good_left.at(i).pt, cam_id_left);
-        cv::Point2f npt_r = undistort_point(good_right.at(i).pt, cam_id_right);
         // Append to the database
-        database->update_feature(good_ids_left.at(i), timestamp, cam_id_left,
-                                 good_left.at(i).pt.x, good_left.at(i).pt.y,
-                                 npt_l.x, npt_l.y);
-        database->update_feature(good_ids_left.at(i), timestamp, cam_id_right,
-                                 good_right.at(i).pt.x, good_right.at(i).pt.y,
-                                 npt_r.x, npt_r.y);
+        obs_left.push_back({good_ids_left.at(i), timestamp, cam_id_left, pts_left.at(i).x, pts_left.at(i).y, npts_left.at(i).x, npts_left.at(i).y});
+        obs_right.push_back({good_ids_left.at(i), timestamp, cam_id_right, pts_right.at(i).x, pts_right.at(i).y, npts_right.at(i).x, npts_right.at(i).y});
     }
+    database->update_features(obs_left);
+    database->update_features(obs_right);
+    database->publish_observations(cam_id_left);
+    database->publish_observations(cam_id_right);
 
 
     // Debug info
@@ -339,28 +345,21 @@ void TrackDescriptor::perform_detection_stereo(const cv::Mat &img0, const cv::Ma
     assert(pts1.empty());
 
     // Extract our features (use FAST with griding)
+    // Each image is done in parallel, and we wait till both are done
     std::vector<cv::KeyPoint> pts0_ext, pts1_ext;
-    boost::thread t_0 = boost::thread(&Grider_FAST::perform_griding, boost::cref(img0), boost::ref(pts0_ext),
-                                      num_features, grid_x, grid_y, threshold, true);
-    boost::thread t_1 = boost::thread(&Grider_FAST::perform_griding, boost::cref(img1), boost::ref(pts1_ext),
-                                      num_features, grid_x, grid_y, threshold, true);
-
-    // Wait till both threads finish
-    t_0.join();
-    t_1.join();
-
-    // For all new points, extract their descriptors
     cv::Mat desc0_ext, desc1_ext;
-
-    // Use C++11 lamdas so we can pass all theses variables by reference
-    std::thread t_desc0 = std::thread([this,&img0,&pts0_ext,&desc0_ext]{this->orb0->compute(img0, pts0_ext, desc0_ext);});
-    std::thread t_desc1 = std::thread([this,&img1,&pts1_ext,&desc1_ext]{this->orb1->compute(img1, pts1_ext, desc1_ext);});
-    //std::thread t_desc0 = std::thread([this,&img0,&pts0_ext,&desc0_ext]{this->freak0->compute(img0, pts0_ext, desc0_ext);});
-    //std::thread t_desc1 = std::thread([this,&img1,&pts1_ext,&desc1_ext]{this->freak1->compute(img1, pts1_ext, desc1_ext);});
-
-    // Wait till both threads finish
-    t_desc0.join();
-    t_desc1.join();
+    pool->run({
+        {"desc_detection", [&] {
+            Grider_FAST::perform_griding(img0, pts0_ext, num_features, grid_x, grid_y, threshold, true);
+            this->orb0->compute(img0, pts0_ext, desc0_ext);
+            //this->freak0->compute(img0, pts0_ext, desc0_ext);
+        }},
+        {"desc_detection", [&] {
+            Grider_FAST::perform_griding(img1, pts1_ext, num_features, grid_x, grid_y, threshold, true);
+            this->orb1->compute(img1, pts1_ext, desc1_ext);
+            //this->freak1->compute(img1, pts1_ext, desc1_ext);
+        }}
+    });
 
     // Do matching from the left to the right image
     std::vector<cv::DMatch> matches;
@@ -420,10 +419,8 @@ void TrackDescriptor::robust_match(std::vector<cv::KeyPoint>& pts0, std::vector<
     // Normalize these points, so we can then do ransac
     // We don't want to do ransac on distorted image uvs since the mapping is nonlinear
     std::vector<cv::Point2f> pts0_n, pts1_n;
-    for(size_t i=0; i<pts0_rsc.size(); i++) {
-        pts0_n.push_back(undistort_point(pts0_rsc.at(i),id0));
-        pts1_n.push_back(undistort_point(pts0_rsc.at(i),id1));
-    }
+    undistort_points(pts0_rsc, id0, pts0_n);
+    undistort_points(pts0_rsc, id1, pts1_n);
 
     // Do RANSAC outlier rejection (note since we normalized the max pixel error is now in the normalized cords)
     std::vector<uchar> mask_rsc;
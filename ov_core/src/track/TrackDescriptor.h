@@ -79,6 +79,15 @@ namespace ov_core {
 
     protected:
 
+        /**
+         * @brief Creates the per-camera storage (including our descriptors) for a camera
+         * @param cam_id camera id we want to create storage for
+         */
+        void init_camera_storage(size_t cam_id) override {
+            TrackBase::init_camera_storage(cam_id);
+            desc_last[cam_id];
+        }
+
         /**
          * @brief Detects new features in the current image
          * @param img0 image we will detect features on
@@ -32,12 +32,11 @@ void TrackKLT::feed_monocular(double timestamp, cv::Mat &img, size_t cam_id) {
     // Lock this data feed for this camera
     std::unique_lock<std::mutex> lck(mtx_feeds.at(cam_id));
 
-    // Histogram equalize
-    cv::equalizeHist(img, img);
-
-    // Extract the new image pyramid
-    std::vector<cv::Mat> imgpyr;
-    cv::buildOpticalFlowPyramid(img, imgpyr, win_size, pyr_levels);
+    // Histogram equalize and extract the new image pyramid
+    // Both are written into our spare buffers for this camera, so no memory is allocated after the first frame
+    std::vector<cv::Mat> &imgpyr = img_pyramid_curr[cam_id];
+    cv::equalizeHist(img, img_equalized[cam_id]);
+    cv::buildOpticalFlowPyramid(img_equalized[cam_id], imgpyr, win_size, pyr_levels);
     rT2 =  boost::posix_time::microsec_clock::local_time();
 
     // If we didn't have any successful tracks last time, just extract this time
@@ -46,8 +45,7 @@ void TrackKLT::feed_monocular(double timestamp, cv::Mat &img, size_t cam_id) {
         // Detect new features
         perform_detection_monocular(imgpyr, pts_last[cam_id], ids_last[cam_id]);
         // Save the current image and pyramid
-        img_last[cam_id] = img.clone();
-        img_pyramid_last[cam_id] = imgpyr;
+        swap_pyramid(cam_id);
         return;
     }
 
@@ -75,8 +73,7 @@ void TrackKLT::feed_monocular(double timestamp, cv::Mat &img, size_t cam_id) {
 
     // If any of our mask is empty, that means we didn't have enough to do ransac, so just return
     if(mask_ll.empty()) {
-        img_last[cam_id] = img.clone();
-        img_pyramid_last[cam_id] = imgpyr;
+        swap_pyramid(cam_id);
         pts_last[cam_id].clear();
         ids_last[cam_id].clear();
         printf(RED "[KLT-EXTRACTOR]: Failed to get enough points to do RANSAC, resetting.....\n" RESET);
@@ -105,16 +102,18 @@ void TrackKLT::feed_monocular(double timestamp, cv::Mat &img, size_t cam_id) {
 
 
     // Update our feature database, with theses new observations
+    std::vector<cv::Point2f> pts_left, npts_left;
+    cv::KeyPoint::convert(good_left, pts_left);
+    undistort_points(pts_left, cam_id, npts_left);
+    std::vector<ObservationRing::Observation> obs_left;
     for(size_t i=0; i<good_left.size(); i++) {
-        cv::Point2f npt_l = undistort_point(good_left.at(i).pt, cam_id);
-        database->update_feature(good_ids_left.at(i), timestamp, cam_id,
-                                 good_left.at(i).pt.x, good_left.at(i).pt.y,
-                                 npt_l.x, npt_l.y);
+        obs_left.push_back({good_ids_left.at(i), timestamp, cam_id, pts_left.at(i).x, pts_left.at(i).y, npts_left.at(i).x, npts_left.at(i).y});
     }
+    database->update_features(obs_left);
+    database->publish_observations(cam_id);
 
     // Move forward in time
-    img_last[cam_id] = img.clone();
-    img_pyramid_last[cam_id] = imgpyr;
+    swap_pyramid(cam_id);
     pts_last[cam_id] = good_left;
     ids_last[cam_id] = good_ids_left;
     rT5 =  boost::posix_time::microsec_clock::local_time();
@@ -139,23 +138,22 @@ void TrackKLT::feed_stereo(double timestamp, cv::Mat &img_leftin, cv::Mat &img_r
     std::unique_lock<std::mutex> lck1(mtx_feeds.at(cam_id_left));
     std::unique_lock<std::mutex> lck2(mtx_feeds.at(cam_id_right));
 
-    // Histogram equalize
-    cv::Mat img_left, img_right;
-    boost::thread t_lhe = boost::thread(cv::equalizeHist, boost::cref(img_leftin), boost::ref(img_left));
-    boost::thread t_rhe = boost::thread(cv::equalizeHist, boost::cref(img_rightin), boost::ref(img_right));
-    t_lhe.join();
-    t_rhe.join();
-
-    // Extract image pyramids (boost seems to require us to put all the arguments even if there are defaults....)
-    std::vector<cv::Mat> imgpyr_left, imgpyr_right;
-    boost::thread t_lp = boost::thread(cv::buildOpticalFlowPyramid, boost::cref(img_left),
-                                       boost::ref(imgpyr_left), boost::ref(win_size), boost::ref(pyr_levels), false,
-                                       cv::BORDER_REFLECT_101, cv::BORDER_CONSTANT, true);
-    boost::thread t_rp = boost::thread(cv::buildOpticalFlowPyramid, boost::cref(img_right),
-                                       boost::ref(imgpyr_right), boost::ref(win_size), boost::ref(pyr_levels),
-                                       false, cv::BORDER_REFLECT_101, cv::BORDER_CONSTANT, true);
-    t_lp.join();
-    t_rp.join();
+    // Histogram equalize and extract image pyramids, each image is done in parallel
+    // Both are written into our spare buffers for each camera, so no memory is allocated after the first frame
+    cv::Mat &img_left = img_equalized[cam_id_left];
+    cv::Mat &img_right = img_equalized[cam_id_right];
+    std::vector<cv::Mat> &imgpyr_left = img_pyramid_curr[cam_id_left];
+    std::vector<cv::Mat> &imgpyr_right = img_pyramid_curr[cam_id_right];
+    pool->run({
+        {"klt_pyramid", [&] {
+            cv::equalizeHist(img_leftin, img_left);
+            cv::buildOpticalFlowPyramid(img_left, imgpyr_left, win_size, pyr_levels, false);
+        }},
+        {"klt_pyramid", [&] {
+            cv::equalizeHist(img_rightin, img_right);
+            cv::buildOpticalFlowPyramid(img_right, imgpyr_right, win_size, pyr_levels, false);
+        }}
+    });
     rT2 =  boost::posix_time::microsec_clock::local_time();
 
     // If we didn't have any successful tracks last time, just extract this time
@@ -164,10 +162,8 @@ void TrackKLT::feed_stereo(double timestamp, cv::Mat &img_leftin, cv::Mat &img_r
         // Track into the new image
         perform_detection_stereo(imgpyr_left, imgpyr_right, pts_last[cam_id_left], pts_last[cam_id_right], ids_last[cam_id_left], ids_last[cam_id_right]);
         // Save the current image and pyramid
-        img_last[cam_id_left] = img_left.clone();
-        img_last[cam_id_right] = img_right.clone();
-        img_pyramid_last[cam_id_left] = imgpyr_left;
-        img_pyramid_last[cam_id_right] = imgpyr_right;
+        swap_pyramid(cam_id_left);
+        swap_pyramid(cam_id_right);
         return;
     }
 
@@ -187,15 +183,15 @@ void TrackKLT::feed_stereo(double timestamp, cv::Mat &img_leftin, cv::Mat &img_r
     std::vector<cv::KeyPoint> pts_left_new = pts_last[cam_id_left];
     std::vector<cv::KeyPoint> pts_right_new = pts_last[cam_id_right];
 
-    // Lets track temporally
-    boost::thread t_ll = boost::thread(&TrackKLT::perform_matching, this, boost::cref(img_pyramid_last[cam_id_left]), boost::cref(imgpyr_left),
-                                       boost::ref(pts_last[cam_id_left]), boost::ref(pts_left_new), cam_id_left, cam_id_left, boost::ref(mask_ll));
-    boost::thread t_rr = boost::thread(&TrackKLT::perform_matching, this, boost::cref(img_pyramid_last[cam_id_right]), boost::cref(imgpyr_right),
-                                       boost::ref(pts_last[cam_id_right]), boost::ref(pts_right_new), cam_id_right, cam_id_right, boost::ref(mask_rr));
-
-    // Wait till both threads finish
-    t_ll.join();
-    t_rr.join();
+    // Lets track temporally, and wait till both are done
+    pool->run({
+        {"klt_matching", [&] {
+            perform_matching(img_pyramid_last[cam_id_left], imgpyr_left, pts_last[cam_id_left], pts_left_new, cam_id_left, cam_id_left, mask_ll);
+        }},
+        {"klt_matching", [&] {
+            perform_matching(img_pyramid_last[cam_id_right], imgpyr_right, pts_last[cam_id_right], pts_right_new, cam_id_right, cam_id_right, mask_rr);
+        }}
+    });
     rT4 =  boost::posix_time::microsec_clock::local_time();
 
 
@@ -216,10 +212,8 @@ void TrackKLT::feed_stereo(double timestamp, cv::Mat &img_leftin, cv::Mat &img_r
 
     // If any of our masks are empty, that means we didn't have enough to do ransac, so just return
     if(mask_ll.empty() || mask_rr.empty()) {
-        img_last[cam_id_left] = img_left.clone();
-        img_last[cam_id_right] = img_right.clone();
-        img_pyramid_last[cam_id_left] = imgpyr_left;
-        img_pyramid_last[cam_id_right] = imgpyr_right;
+        swap_pyramid(cam_id_left);
+        swap_pyramid(cam_id_right);
         pts_last[cam_id_left].clear();
         pts_last[cam_id_right].clear();
         ids_last[cam_id_left].clear();
@@ -284,24 +278,26 @@ void TrackKLT::feed_stereo(double timestamp, cv::Mat &img_leftin, cv::Mat &img_r
     //===================================================================================
 
     // Update our feature database, with theses new observations
+    std::vector<cv::Point2f> pts_left, pts_right, npts_left, npts_right;
+    cv::KeyPoint::convert(good_left, pts_left);
+    cv::KeyPoint::convert(good_right, pts_right);
+    undistort_points(pts_left, cam_id_left, npts_left);
+    undistort_points(pts_right, cam_id_right, npts_right);
+    std::vector<ObservationRing::Observation> obs_left, obs_right;
     for(size_t i=0; i<good_left.size(); i++) {
-        cv::Point2f npt_l = undistort_point(good_left.at(i).pt, cam_id_left);
-        database->update_feature(good_ids_left.at(i), timestamp, cam_id_left,
-                                 good_left.at(i).pt.x, good_left.at(i).pt.y,
-                                 npt_l.x, npt_l.y);
+        obs_left.push_back({good_ids_left.at(i), timestamp, cam_id_left, pts_left.at(i).x, pts_left.at(i).y, npts_left.at(i).x, npts_left.at(i).y});
     }
     for(size_t i=0; i<good_right.size(); i++) {
-        cv::Point2f npt_r = undistort_point(good_right.at(i).pt, cam_id_right);
-        database->update_feature(good_ids_right.at(i), timestamp, cam_id_right,
-                                 good_right.at(i).pt.x, good_right.at(i).pt.y,
-                                 npt_r.x, npt_r.y);
+        obs_right.push_back({good_ids_right.at(i), timestamp, cam_id_right, pts_right.at(i).x, pts_right.at(i).y, npts_right.at(i).x, npts_right.at(i).y});
     }
+    database->update_features(obs_left);
+    database->update_features(obs_right);
+    database->publish_observations(cam_id_left);
+    database->publish_observations(cam_id_right);
 
     // Move forward in time
-    img_last[cam_id_left] = img_left.clone();
-    img_last[cam_id_right] = img_right.clone();
-    img_pyramid_last[cam_id_left] = imgpyr_left;
-    img_pyramid_last[cam_id_right] = imgpyr_right;
+    swap_pyramid(cam_id_left);
+    swap_pyramid(cam_id_right);
     pts_last[cam_id_left] = good_left;
     pts_last[cam_id_right] = good_right;
     ids_last[cam_id_left] = good_ids_left;
@@ -568,10 +564,8 @@ void TrackKLT::perform_matching(const std::vector<cv::Mat>& img0pyr, const std::
     // Normalize these points, so we can then do ransac
     // We don't want to do ransac on distorted image uvs since the mapping is nonlinear
     std::vector<cv::Point2f> pts0_n, pts1_n;
-    for(size_t i=0; i<pts0.size(); i++) {
-        pts0_n.push_back(undistort_point(pts0.at(i),id0));
-        pts1_n.push_back(undistort_point(pts1.at(i),id1));
-    }
+    undistort_points(pts0, id0, pts0_n);
+    undistort_points(pts1, id1, pts1_n);
 
     // Do RANSAC outlier rejection (note since we normalized the max pixel error is now in the normalized cords)
     std::vector<uchar> mask_rsc;
@@ -80,6 +80,30 @@ namespace ov_core {
 
     protected:
 
+        /**
+         * @brief Creates the per-camera storage (including our image pyramid) for a camera
+         * @param cam_id camera id we want to create storage for
+         */
+        void init_camera_storage(size_t cam_id) override {
+            TrackBase::init_camera_storage(cam_id);
+            img_pyramid_last[cam_id];
+            img_pyramid_curr[cam_id];
+            img_equalized[cam_id];
+        }
+
+        /**
+         * @brief Makes the current image pyramid of a camera the last one
+         *
+         * The pyramid buffers are swapped instead of copied, and the old last pyramid becomes the spare we build the next image into.
+         * Our last image just references the first level of the pyramid so that it is not copied either.
+         *
+         * @param cam_id camera id we are moving forward in time
+         */
+        void swap_pyramid(size_t cam_id) {
+            std::swap(img_pyramid_last[cam_id], img_pyramid_curr[cam_id]);
+            img_last[cam_id] = img_pyramid_last[cam_id].at(0);
+        }
+
         /**
          * @brief Detects new features in the current image
          * @param img0pyr image we will detect features on (first level of pyramid)
@@ -144,6 +168,12 @@ namespace ov_core {
         // Last set of image pyramids
         std::map<size_t, std::vector<cv::Mat>> img_pyramid_last;
 
+        // Spare pyramid buffers that the current images are built into (swapped with the last set once we are done)
+        std::map<size_t, std::vector<cv::Mat>> img_pyramid_curr;
+
+        // Buffers for the histogram equalized current images
+        std::map<size_t, cv::Mat> img_equalized;
+
     };
 
 
@@ -41,6 +41,7 @@ void TrackSIM::feed_measurement_simulation(double timestamp, const std::vector<i
         // Our good ids and points
         std::vector<cv::KeyPoint> good_left;
         std::vector<size_t> good_ids_left;
+        std::vector<ObservationRing::Observation> obs_left;
 
         // Update our feature database, with theses new observations
         // NOTE: we add the "currid" since we need to offset the simulator
@@ -56,12 +57,17 @@ void TrackSIM::feed_measurement_simulation(double timestamp, const std::vector<i
             kpt.pt.y = feat.second(1);
             good_left.push_back(kpt);
             good_ids_left.push_back(id);
+        }
 
-            // Append to the database
-            cv::Point2f npt_l = undistort_point(kpt.pt, cam_id);
-            database->update_feature(id, timestamp, cam_id,
-                                     kpt.pt.x, kpt.pt.y, npt_l.x, npt_l.y);
+        // Undistort all our points at once, and append to the database
+        std::vector<cv::Point2f> pts_left, npts_left;
+        cv::KeyPoint::convert(good_left, pts_left);
+        undistort_points(pts_left, (size_t)cam_id, npts_left);
+        for(size_t j=0; j<good_left.size(); j++) {
+            obs_left.push_back({good_ids_left.at(j), timestamp, (size_t)cam_id, pts_left.at(j).x, pts_left.at(j).y, npts_left.at(j).x, npts_left.at(j).y});
         }
+        database->update_features(obs_left);
+        database->publish_observations(cam_id);
 
         // Get our width and height
         auto wh = camera_wh.at(cam_id);
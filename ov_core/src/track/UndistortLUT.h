@@ -0,0 +1,203 @@
+/*
+ * OpenVINS: An Open Platform for Visual-Inertial Research
+ * Copyright (C) 2019 Patrick Geneva
+ * Copyright (C) 2019 Kevin Eckenhoff
+ * Copyright (C) 2019 Guoquan Huang
+ * Copyright (C) 2019 OpenVINS Contributors
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef OV_CORE_UNDISTORT_LUT_H
+#define OV_CORE_UNDISTORT_LUT_H
+
+
+#include <vector>
+#include <cmath>
+#include <algorithm>
+
+#include <opencv2/core/core.hpp>
+
+
+namespace ov_core {
+
+    /**
+     * @brief Lookup table that maps raw pixels of a camera to undistorted/normalized coordinates.
+     *
+     * We undistort a regular grid of pixels that covers the whole image once, and then find the normalized coordinate of any point
+     * with a bilinear interpolation of its four surrounding grid nodes.
+     * The table remembers the intrinsics it was built with, so that the caller can check if it needs to be rebuilt after a calibration update.
+     * It also measures its own interpolation error, since rebuilding for a calibration change smaller than this does not make it any more accurate.
+     * Points outside of the grid are reported back to the caller so they can be undistorted exactly.
+     */
+    class UndistortLUT {
+
+    public:
+
+        /**
+         * @brief Builds the table for a given image size and calibration
+         * @param width Width of the image in pixels
+         * @param height Height of the image in pixels
+         * @param step Spacing of the grid nodes in pixels
+         * @param camK Camera intrinsic matrix the table is for
+         * @param camD Camera distortion parameters the table is for
+         * @param fisheye If the camera is a fisheye model
+         * @param undistort Function that will exactly undistort a vector of grid nodes, called as undistort(pts_in, camK, camD, pts_out)
+         */
+        template<typename Func>
+        void build(int width, int height, int step, const cv::Matx33d &camK, const cv::Vec4d &camD, bool fisheye, Func undistort) {
+            // Our grid will always reach past the bottom right corner of the image
+            this->step = std::max(step, 1);
+            nx = width / this->step + 2;
+            ny = height / this->step + 2;
+            std::vector<cv::Point2f> nodes, nodes_n;
+            nodes.reserve((size_t) (nx * ny));
+            for (int iy = 0; iy < ny; iy++) {
+                for (int ix = 0; ix < nx; ix++) {
+                    nodes.emplace_back((float) (ix * this->step), (float) (iy * this->step));
+                }
+            }
+            // Undistort all nodes and store them as flat arrays
+            undistort(nodes, camK, camD, nodes_n);
+            lut_x.resize(nodes_n.size());
+            lut_y.resize(nodes_n.size());
+            for (size_t i = 0; i < nodes_n.size(); i++) {
+                lut_x[i] = nodes_n[i].x;
+                lut_y[i] = nodes_n[i].y;
+            }
+            this->camK = camK;
+            this->camD = camD;
+            this->fisheye = fisheye;
+            // Measure the interpolation error, which is largest in the middle of a cell
+            // We check every fourth row and column of cells, and always the border cells where the distortion is strongest
+            int ncx = (width + this->step - 1) / this->step;
+            int ncy = (height + this->step - 1) / this->step;
+            std::vector<cv::Point2f> centers, centers_n, centers_lut;
+            std::vector<size_t> outside;
+            for (int iy = 0; iy < ncy; iy++) {
+                if (iy % 4 != 0 && iy != ncy - 1)
+                    continue;
+                for (int ix = 0; ix < ncx; ix++) {
+                    if (ix % 4 != 0 && ix != ncx - 1)
+                        continue;
+                    centers.emplace_back(std::min((ix + 0.5f) * this->step, (float) (width - 1)),
+                                         std::min((iy + 0.5f) * this->step, (float) (height - 1)));
+                }
+            }
+            undistort(centers, camK, camD, centers_n);
+            lookup(centers, centers_lut, outside);
+            double fmax = std::max(camK(0, 0), camK(1, 1));
+            max_error = 0;
+            for (size_t i = 0; i < centers.size(); i++) {
+                max_error = std::max(max_error, fmax * std::hypot(centers_lut[i].x - centers_n[i].x, centers_lut[i].y - centers_n[i].y));
+            }
+        }
+
+        /**
+         * @brief Checks if a calibration is close enough to the one this table was built with
+         *
+         * The change of the focal lengths and center is directly in pixels.
+         * A change of a distortion parameter is converted into pixels by the focal length, which bounds how much it moves points in the image.
+         * If no tolerance is given, we use the interpolation error of this table (see get_interpolation_error()).
+         *
+         * @param camK Camera intrinsic matrix
+         * @param camD Camera distortion parameters
+         * @param fisheye If the camera is a fisheye model
+         * @param tolerance Largest change in pixels we allow before the table is stale (non-positive to use our interpolation error)
+         * @return True if this table can still be used for this calibration
+         */
+        bool is_valid(const cv::Matx33d &camK, const cv::Vec4d &camD, bool fisheye, double tolerance) const {
+            if (lut_x.empty() || fisheye != this->fisheye)
+                return false;
+            double diff = std::max(std::abs(camK(0, 0) - this->camK(0, 0)), std::abs(camK(1, 1) - this->camK(1, 1)));
+            diff = std::max(diff, std::max(std::abs(camK(0, 2) - this->camK(0, 2)), std::abs(camK(1, 2) - this->camK(1, 2))));
+            double fmax = std::max(camK(0, 0), camK(1, 1));
+            for (int i = 0; i < 4; i++) {
+                diff = std::max(diff, fmax * std::abs(camD(i) - this->camD(i)));
+            }
+            return diff <= ((tolerance > 0) ? tolerance : max_error);
+        }
+
+        /**
+         * @brief Largest error in pixels of our interpolation, measured against the exact undistortion when built
+         *
+         * This grows with the square of the grid step, for a 752x480 radtan camera (EuRoC) it is about 0.02 pixels with a step of 4.
+         */
+        double get_interpolation_error() const {
+            return max_error;
+        }
+
+        /**
+         * @brief Finds the normalized coordinates of a set of points
+         * @param pts_in uv 2x1 points that we will undistort
+         * @param pts_out undistorted 2x1 points (will be resized to match the input)
+         * @param outside Indices of the points that are not covered by the grid (their output is not valid)
+         */
+        void lookup(const std::vector<cv::Point2f> &pts_in, std::vector<cv::Point2f> &pts_out, std::vector<size_t> &outside) const {
+            const size_t n = pts_in.size();
+            const float istep = 1.0f / (float) step;
+            pts_out.resize(n);
+            std::vector<char> inside(n);
+            // Clamp into the grid so that every point can be interpolated without branching
+            for (size_t i = 0; i < n; i++) {
+                float gx = pts_in[i].x * istep;
+                float gy = pts_in[i].y * istep;
+                int ix = (int) std::floor(gx);
+                int iy = (int) std::floor(gy);
+                inside[i] = (ix >= 0 && iy >= 0 && ix < nx - 1 && iy < ny - 1);
+                ix = std::min(std::max(ix, 0), nx - 2);
+                iy = std::min(std::max(iy, 0), ny - 2);
+                float ax = gx - (float) ix;
+                float ay = gy - (float) iy;
+                size_t i00 = (size_t) (iy * nx + ix);
+                size_t i10 = i00 + (size_t) nx;
+                pts_out[i].x = (1 - ay) * ((1 - ax) * lut_x[i00] + ax * lut_x[i00 + 1]) + ay * ((1 - ax) * lut_x[i10] + ax * lut_x[i10 + 1]);
+                pts_out[i].y = (1 - ay) * ((1 - ax) * lut_y[i00] + ax * lut_y[i00 + 1]) + ay * ((1 - ax) * lut_y[i10] + ax * lut_y[i10 + 1]);
+            }
+            // Report all points we could not interpolate
+            outside.clear();
+            for (size_t i = 0; i < n; i++) {
+                if (!inside[i])
+                    outside.push_back(i);
+            }
+        }
+
+    protected:
+
+        /// Spacing of the grid nodes in pixels
+        int step = 1;
+
+        /// Number of grid nodes along the columns and rows
+        int nx = 0, ny = 0;
+
+        /// Normalized x and y coordinate of each grid node (row major)
+        std::vector<float> lut_x, lut_y;
+
+        /// Camera intrinsics this table was built with
+        cv::Matx33d camK;
+
+        /// Camera distortion this table was built with
+        cv::Vec4d camD;
+
+        /// If this table was built for a fisheye model
+        bool fisheye = false;
+
+        /// Largest interpolation error in pixels we measured when built
+        double max_error = 0;
+
+    };
+
+
+}
+
+#endif /* OV_CORE_UNDISTORT_LUT_H */
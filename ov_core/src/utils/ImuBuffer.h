@@ -0,0 +1,224 @@
+/*
+ * OpenVINS: An Open Platform for Visual-Inertial Research
+ * Copyright (C) 2019 Patrick Geneva
+ * Copyright (C) 2019 Kevin Eckenhoff
+ * Copyright (C) 2019 Guoquan Huang
+ * Copyright (C) 2019 OpenVINS Contributors
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef OV_CORE_IMU_BUFFER_H
+#define OV_CORE_IMU_BUFFER_H
+
+
+#include <vector>
+#include <cassert>
+#include <cstddef>
+#include <Eigen/Eigen>
+
+
+namespace ov_core {
+
+    /**
+     * @brief Fixed capacity ring buffer of inertial readings.
+     *
+     * This is the single history of IMU messages that the propagator, initializer, and zero velocity updater all read from.
+     * Once the buffer is full, adding a new reading will overwrite the oldest one, so nothing ever needs to be shifted.
+     * Readings are always kept in time order, which allows for any time to be found with a binary search.
+     * A reading that arrives late is inserted into its place by shifting the few newer readings, so small amounts of jitter are cheap.
+     * Readings with the same timestamp as one we already have are dropped.
+     * This is not thread safe, so it should only be used by the thread that runs the estimator.
+     */
+    class ImuBuffer {
+
+    public:
+
+        /**
+         * @brief Struct for a single imu measurement (time, wm, am)
+         */
+        struct IMUDATA {
+
+            /// Timestamp of the reading
+            double timestamp;
+
+            /// Gyroscope reading, angular velocity (rad/s)
+            Eigen::Matrix<double, 3, 1> wm;
+
+            /// Accelerometer reading, linear acceleration (m/s^2)
+            Eigen::Matrix<double, 3, 1> am;
+
+        };
+
+        /**
+         * @brief Default constructor
+         * @param capacity Max number of readings we will keep (the oldest are overwritten)
+         */
+        ImuBuffer(size_t capacity) {
+            assert(capacity > 0);
+            buffer.resize(capacity);
+        }
+
+        /**
+         * @brief Adds a new reading in time order, overwriting the oldest if we are full
+         *
+         * In the normal case the reading is the newest we have and is just appended.
+         * Otherwise we walk back from the newest reading to find its place, so the cost grows with how late it is.
+         * A reading older than everything in a full buffer is dropped, as it would be the first to be overwritten.
+         *
+         * @param data Reading we want to add
+         * @return False if the reading was dropped (duplicate timestamp or too old)
+         */
+        bool feed(const IMUDATA &data) {
+            // Find where this reading belongs (just the end if it is in order)
+            size_t pos = count;
+            while (pos > 0 && at(pos - 1).timestamp > data.timestamp) {
+                pos--;
+            }
+            // Drop it if we already have a reading at this time
+            if (pos > 0 && at(pos - 1).timestamp == data.timestamp) {
+                num_duplicates++;
+                return false;
+            }
+            // If we are full, then make room by removing our oldest reading
+            if (count == buffer.size()) {
+                if (pos == 0) {
+                    num_dropped++;
+                    return false;
+                }
+                head = (head + 1 == buffer.size()) ? 0 : head + 1;
+                count--;
+                pos--;
+            }
+            // Shift all newer readings forward by one, and insert it
+            count++;
+            for (size_t i = count - 1; i > pos; i--) {
+                slot(i) = slot(i - 1);
+            }
+            slot(pos) = data;
+            if (pos + 1 < count) {
+                num_reordered++;
+            }
+            return true;
+        }
+
+        /// Number of readings we currently have
+        size_t size() const {
+            return count;
+        }
+
+        /// Max number of readings we can keep
+        size_t capacity() const {
+            return buffer.size();
+        }
+
+        /// If we have no readings
+        bool empty() const {
+            return count == 0;
+        }
+
+        /**
+         * @brief Gets a reading by its position in time
+         * @param i Index of the reading, where zero is the oldest
+         * @return Reading at that position
+         */
+        const IMUDATA &at(size_t i) const {
+            assert(i < count);
+            size_t idx = head + i;
+            if (idx >= buffer.size()) idx -= buffer.size();
+            return buffer[idx];
+        }
+
+        /// Newest reading we have (buffer should not be empty)
+        const IMUDATA &back() const {
+            return at(count - 1);
+        }
+
+        /// Number of readings that arrived out of order and where inserted before newer ones
+        size_t get_num_reordered() const {
+            return num_reordered;
+        }
+
+        /// Number of readings that where dropped since we already had one at the same time
+        size_t get_num_duplicates() const {
+            return num_duplicates;
+        }
+
+        /// Number of readings that where dropped since they where older than our full history
+        size_t get_num_dropped() const {
+            return num_dropped;
+        }
+
+        /**
+         * @brief Binary search for the first reading that is not older than a given time
+         * @param timestamp Time we want to search for
+         * @return Index of the first reading with a timestamp >= the given one (size() if there is none)
+         */
+        size_t lower_bound(double timestamp) const {
+            size_t lo = 0, hi = count;
+            while (lo < hi) {
+                size_t mid = lo + (hi - lo) / 2;
+                if (at(mid).timestamp < timestamp) lo = mid + 1;
+                else hi = mid;
+            }
+            return lo;
+        }
+
+        /**
+         * @brief Binary search for the first reading that is newer than a given time
+         * @param timestamp Time we want to search for
+         * @return Index of the first reading with a timestamp > the given one (size() if there is none)
+         */
+        size_t upper_bound(double timestamp) const {
+            size_t lo = 0, hi = count;
+            while (lo < hi) {
+                size_t mid = lo + (hi - lo) / 2;
+                if (at(mid).timestamp <= timestamp) lo = mid + 1;
+                else hi = mid;
+            }
+            return lo;
+        }
+
+    protected:
+
+        /// Gets the storage of a reading by its position in time
+        IMUDATA &slot(size_t i) {
+            size_t idx = head + i;
+            if (idx >= buffer.size()) idx -= buffer.size();
+            return buffer[idx];
+        }
+
+        /// Storage of our readings
+        std::vector<IMUDATA> buffer;
+
+        /// Index of the oldest reading in our storage
+        size_t head = 0;
+
+        /// Number of readings we have
+        size_t count = 0;
+
+        /// Number of readings inserted out of order
+        size_t num_reordered = 0;
+
+        /// Number of readings dropped for having a duplicate timestamp
+        size_t num_duplicates = 0;
+
+        /// Number of readings dropped for being too old
+        size_t num_dropped = 0;
+
+    };
+
+
+}
+
+#endif /* OV_CORE_IMU_BUFFER_H */
@@ -0,0 +1,303 @@
+/*
+ * OpenVINS: An Open Platform for Visual-Inertial Research
+ * Copyright (C) 2019 Patrick Geneva
+ * Copyright (C) 2019 Guoquan Huang
+ * Copyright (C) 2019 OpenVINS Contributors
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef OV_CORE_TASK_POOL_H
+#define OV_CORE_TASK_POOL_H
+
+
+#include <map>
+#include <algorithm>
+#include <deque>
+#include <mutex>
+#include <atomic>
+#include <thread>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <exception>
+#include <functional>
+#include <condition_variable>
+
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+#include "utils/colors.h"
+
+
+namespace ov_core {
+
+    /**
+     * @brief Persistent pool of worker threads that our trackers and manager submit work to.
+     *
+     * The threads are created once and then wait for tasks, so we do not pay for creating and destroying threads every frame.
+     * Work is submitted as a batch with run(), and the calling thread will also help to process the batch until it is done.
+     * Thus a pool with zero worker threads will just run everything serially on the caller, and nested batches can not deadlock.
+     * Each task has a name, and we record how long tasks of each name took so the user can see where the time goes.
+     * If a list of cpu ids is given, then each worker thread will be pinned to one of them (only supported on linux).
+     */
+    class TaskPool {
+
+    public:
+
+        /**
+         * @brief Single named piece of work
+         */
+        struct Task {
+
+            /// Name of this task, used to report its timing
+            std::string name;
+
+            /// Function that will be called to do the work
+            std::function<void()> func;
+
+        };
+
+        /**
+         * @brief Timing statistics of all tasks with the same name
+         */
+        struct TaskTiming {
+
+            /// Number of times this task has been run
+            size_t count = 0;
+
+            /// Total time spent in this task (seconds)
+            double total = 0;
+
+            /// Longest time a single run of this task took (seconds)
+            double max = 0;
+
+        };
+
+        /**
+         * @brief Default constructor, will start all worker threads
+         * @param num_threads Number of worker threads (the thread calling run() will also do work)
+         * @param cpu_ids Cpus we should pin our worker threads to (empty to not pin)
+         */
+        TaskPool(int num_threads, const std::vector<int> &cpu_ids = std::vector<int>()) {
+            for (int i = 0; i < num_threads; i++) {
+                workers.emplace_back(&TaskPool::worker_loop, this);
+#if defined(__linux__)
+                if (!cpu_ids.empty()) {
+                    cpu_set_t cpuset;
+                    CPU_ZERO(&cpuset);
+                    CPU_SET(cpu_ids.at(i % cpu_ids.size()), &cpuset);
+                    if (pthread_setaffinity_np(workers.back().native_handle(), sizeof(cpu_set_t), &cpuset) != 0) {
+                        printf(YELLOW "[POOL]: unable to pin worker %d to cpu %d\n" RESET, i, cpu_ids.at(i % cpu_ids.size()));
+                    }
+                }
+#endif
+            }
+        }
+
+        /**
+         * @brief Destructor, will finish all queued tasks and then stop our worker threads
+         */
+        ~TaskPool() {
+            {
+                std::unique_lock<std::mutex> lck(mtx_queue);
+                stop = true;
+            }
+            cv_queue.notify_all();
+            for (auto &worker : workers) {
+                worker.join();
+            }
+        }
+
+        /**
+         * @brief Runs a batch of tasks and waits till all of them are done
+         *
+         * The first task is run on the calling thread, while the others are given to our workers.
+         * If any task throws, then the first exception will be re-thrown here after the whole batch is done.
+         *
+         * @param tasks Tasks we want to run, these can be run in any order
+         */
+        void run(const std::vector<Task> &tasks) {
+
+            // Nothing to do if we have no tasks
+            if (tasks.empty())
+                return;
+
+            // Queue all but our first task for the workers
+            auto batch = std::make_shared<Batch>();
+            batch->remaining = tasks.size();
+            if (tasks.size() > 1) {
+                std::unique_lock<std::mutex> lck(mtx_queue);
+                for (size_t i = 1; i < tasks.size(); i++) {
+                    queue.push_back({tasks.at(i), batch});
+                }
+            }
+            cv_queue.notify_all();
+
+            // Run our first task, and then help with any other queued work till our batch is done
+            execute({tasks.at(0), batch});
+            while (batch->remaining > 0) {
+                QueuedTask next;
+                {
+                    std::unique_lock<std::mutex> lck(mtx_queue);
+                    if (queue.empty())
+                        break;
+                    next = queue.front();
+                    queue.pop_front();
+                }
+                execute(next);
+            }
+
+            // Everything of ours has been taken by someone, so wait till it is done
+            std::unique_lock<std::mutex> lck(batch->mtx);
+            batch->cv.wait(lck, [&batch] { return batch->remaining == 0; });
+            if (batch->error) {
+                std::rethrow_exception(batch->error);
+            }
+
+        }
+
+        /// Number of worker threads we have (not including the caller of run())
+        size_t num_threads() {
+            return workers.size();
+        }
+
+        /// Returns the timing statistics of each task name
+        std::map<std::string, TaskTiming> get_timing() {
+            std::unique_lock<std::mutex> lck(mtx_timing);
+            return timing;
+        }
+
+        /**
+         * @brief Prints the average and max time of each task name
+         */
+        void print_timing() {
+            std::unique_lock<std::mutex> lck(mtx_timing);
+            for (const auto &pair : timing) {
+                printf(BLUE "[POOL]: %.4f avg, %.4f max seconds for %s (%d runs)\n" RESET,
+                       pair.second.total / (double) pair.second.count, pair.second.max, pair.first.c_str(), (int) pair.second.count);
+            }
+        }
+
+    protected:
+
+        /**
+         * @brief Tasks submitted by a single call to run()
+         */
+        struct Batch {
+
+            /// Number of tasks that have not finished yet
+            std::atomic<size_t> remaining{0};
+
+            /// First exception thrown by one of the tasks
+            std::exception_ptr error;
+
+            /// Used to wake the caller once all tasks have finished
+            std::mutex mtx;
+            std::condition_variable cv;
+
+        };
+
+        /**
+         * @brief Task that is waiting to be run, and the batch it is a part of
+         */
+        struct QueuedTask {
+
+            /// Task we need to run
+            Task task;
+
+            /// Batch this task is part of
+            std::shared_ptr<Batch> batch;
+
+        };
+
+        /**
+         * @brief Runs a single task, records its timing, and marks it as done in its batch
+         * @param queued Task we want to run
+         */
+        void execute(const QueuedTask &queued) {
+
+            // Run the task and catch anything it throws
+            auto rT1 = std::chrono::steady_clock::now();
+            std::exception_ptr error;
+            try {
+                queued.task.func();
+            } catch (...) {
+                error = std::current_exception();
+            }
+            double dt = std::chrono::duration<double>(std::chrono::steady_clock::now() - rT1).count();
+
+            // Record how long it took
+            {
+                std::unique_lock<std::mutex> lck(mtx_timing);
+                TaskTiming &stats = timing[queued.task.name];
+                stats.count++;
+                stats.total += dt;
+                stats.max = std::max(stats.max, dt);
+            }
+
+            // Mark it as done, and wake the caller if it was the last one
+            std::unique_lock<std::mutex> lck(queued.batch->mtx);
+            if (error && !queued.batch->error) {
+                queued.batch->error = error;
+            }
+            if (--queued.batch->remaining == 0) {
+                queued.batch->cv.notify_all();
+            }
+
+        }
+
+        /**
+         * @brief Main loop of each worker thread, runs queued tasks until we are stopped
+         */
+        void worker_loop() {
+            while (true) {
+                QueuedTask next;
+                {
+                    std::unique_lock<std::mutex> lck(mtx_queue);
+                    cv_queue.wait(lck, [this] { return stop || !queue.empty(); });
+                    if (queue.empty())
+                        return;
+                    next = queue.front();
+                    queue.pop_front();
+                }
+                execute(next);
+            }
+        }
+
+        /// Our worker threads
+        std::vector<std::thread> workers;
+
+        /// Tasks waiting for a thread, protected by our queue mutex
+        std::deque<QueuedTask> queue;
+        std::mutex mtx_queue;
+        std::condition_variable cv_queue;
+
+        /// If our workers should stop once the queue is empty
+        bool stop = false;
+
+        /// Timing statistics of each task name
+        std::map<std::string, TaskTiming> timing;
+        std::mutex mtx_timing;
+
+    };
+
+
+}
+
+#endif /* OV_CORE_TASK_POOL_H */
@@ -0,0 +1,109 @@
+#!/usr/bin/env bash
+
+# Compares a single precision covariance build (ENABLE_FLOAT_COVARIANCE=ON) against the default double build.
+# Each workspace should have ov_msckf built with the respective cmake option.
+# The ATE of both is reported by ov_eval error_comparison, and the NEES of each run by error_singlerun.
+# Finally the difference of the average ATE and NEES of the float build from the double build is printed.
+
+
+#=============================================================
+#=============================================================
+#=============================================================
+
+
+# workspaces that have the double and float builds
+workspaces=(
+    "/home/patrick/workspace/catkin_ws_ov/devel/setup.bash"
+    "/home/patrick/workspace/catkin_ws_ov_float/devel/setup.bash"
+)
+
+# name of each build (the folder the runs will be saved into)
+buildnames=(
+    "double"
+    "float"
+)
+
+# dataset locations
+datasets=(
+    "udel_gore"
+)
+
+# location to save log files into
+save_path="/home/patrick/github/pubs_data/pgeneva/2020_openvins/sim_float"
+
+
+#=============================================================
+#=============================================================
+#=============================================================
+
+
+# Loop through each build
+for h in "${!workspaces[@]}"; do
+
+# Source the workspace of this build
+source ${workspaces[h]}
+
+# Loop through all datasets
+for i in "${!datasets[@]}"; do
+
+# Monte Carlo runs for this dataset
+for j in {00..09}; do
+
+# start timing
+start_time="$(date -u +%s)"
+
+# our save locations
+filename_est="$save_path/algorithms/${buildnames[h]}/${datasets[i]}/estimate_$j.txt"
+filename_gt="$save_path/truths/${datasets[i]}.txt"
+
+# run our ROS launch file (note we send console output to terminator)
+roslaunch ov_msckf pgeneva_sim.launch seed:="$j" dataset:="${datasets[i]}.txt" dosave_pose:="true" path_est:="$filename_est" path_gt:="$filename_gt" &> /dev/null
+
+# print out the time elapsed
+end_time="$(date -u +%s)"
+elapsed="$(($end_time-$start_time))"
+echo "BASH: ${buildnames[h]} - ${datasets[i]} - run $j took $elapsed seconds";
+
+done
+
+done
+done
+
+
+#=============================================================
+#=============================================================
+#=============================================================
+
+
+# ATE of each build
+rosrun ov_eval error_comparison posyaw "$save_path/truths/" "$save_path/algorithms/"
+
+# NEES of each run
+for h in "${!buildnames[@]}"; do
+for i in "${!datasets[@]}"; do
+for j in {00..09}; do
+echo "BASH: ${buildnames[h]} - ${datasets[i]} - run $j";
+rosrun ov_eval error_singlerun posyaw "$save_path/truths/${datasets[i]}.txt" "$save_path/algorithms/${buildnames[h]}/${datasets[i]}/estimate_$j.txt" | grep -A 3 "Normalized Estimation Error Squared"
+done
+done
+done
+
+
+# Delta of the float build from the double build (average ATE and NEES over all runs of each dataset)
+for i in "${!datasets[@]}"; do
+for h in "${!buildnames[@]}"; do
+sum="0 0 0 0"
+count=0
+for j in {00..09}; do
+output=$(rosrun ov_eval error_singlerun posyaw "$save_path/truths/${datasets[i]}.txt" "$save_path/algorithms/${buildnames[h]}/${datasets[i]}/estimate_$j.txt")
+ate=$(echo "$output" | grep "rmse_ori" | awk '{print $3, $7}')
+nees=$(echo "$output" | grep -A 3 "Normalized Estimation Error Squared" | grep "mean_ori" | awk '{print $3, $7}')
+sum=$(echo "$sum $ate $nees" | awk '{print $1+$5, $2+$6, $3+$7, $4+$8}')
+count=$((count+1))
+done
+stats[h]=$(echo "$sum" | awk -v n="$count" '{print $1/n, $2/n, $3/n, $4/n}')
+echo "${stats[h]}" | awk -v name="${buildnames[h]} - ${datasets[i]}" '{printf "BASH: %s - ate_ori = %.3f | ate_pos = %.3f | nees_ori = %.3f | nees_pos = %.3f\n", name, $1, $2, $3, $4}'
+done
+echo "${stats[0]} ${stats[1]}" | awk -v name="${buildnames[1]}-${buildnames[0]} - ${datasets[i]}" '{printf "BASH: %s - ate_ori = %.3f | ate_pos = %.3f | nees_ori = %.3f | nees_pos = %.3f\n", name, $5-$1, $6-$2, $7-$3, $8-$4}'
+done
+
@@ -116,6 +116,8 @@ RosVisualizer::RosVisualizer(ros::NodeHandle &nh, VioManager* app, Simulator *si
 
 void RosVisualizer::visualize() {
 
+    // Make sure the estimator does not change the state while we publish it
+    std::unique_lock<std::mutex> lck = _app->lock_estimator();
 
     // publish current image
     publish_images();
@@ -160,10 +162,32 @@ void RosVisualizer::visualize_odometry(double timestamp) {
     if(!_app->initialized() || (timestamp - _app->initialized_time()) < 1)
         return;
 
-    // Get fast propagate state at the desired timestamp
-    State* state = _app->get_state();
+    // If we have a high rate output, then it has already integrated to the newest reading in its own thread
+    // Thus we do not need to wait on the estimator, and just publish the newest state it has
     Eigen::Matrix<double,13,1> state_plus = Eigen::Matrix<double,13,1>::Zero();
-    _app->get_propagator()->fast_state_propagate(state, timestamp, state_plus);
+    Eigen::Matrix<double,6,6> covariance_posori;
+    Eigen::Matrix<double,3,3> covariance_v;
+    std::shared_ptr<FastPropagator> fastprop = _app->get_fast_propagator();
+    if(fastprop != nullptr) {
+        FastPropagator::StateSnapshot snapshot;
+        if(!fastprop->get_latest(snapshot))
+            return;
+        timestamp = snapshot.timestamp;
+        state_plus.block(0,0,4,1) = snapshot.q_GtoI;
+        state_plus.block(4,0,3,1) = snapshot.p_IinG;
+        state_plus.block(7,0,3,1) = snapshot.v_IinG;
+        state_plus.block(10,0,3,1) = snapshot.w_hat;
+        covariance_posori = snapshot.cov_posori;
+        covariance_v = snapshot.cov_v;
+    } else {
+        // Make sure the estimator does not change the state while we propagate it
+        std::unique_lock<std::mutex> lck = _app->lock_estimator();
+        // Get fast propagate state at the desired timestamp
+        State* state = _app->get_state();
+        _app->get_propagator()->fast_state_propagate(state, timestamp, state_plus);
+        covariance_posori = StateHelper::get_marginal_covariance(state, {state->_imu->pose()->p(), state->_imu->pose()->q()});
+        covariance_v = StateHelper::get_marginal_covariance(state, {state->_imu->v()});
+    }
 
     // Our odometry message
     nav_msgs::Odometry odomIinM;
@@ -182,10 +206,6 @@ void RosVisualizer::visualize_odometry(double timestamp) {
     // Finally set the covariance in the message (in the order position then orientation as per ros convention)
     // TODO: this currently is an approximation since this should actually evolve over our propagation period
     // TODO: but to save time we only propagate the mean and not the uncertainty, but maybe we should try to prop the covariance?
-    std::vector<Type*> statevars;
-    statevars.push_back(state->_imu->pose()->p());
-    statevars.push_back(state->_imu->pose()->q());
-    Eigen::Matrix<double,6,6> covariance_posori = StateHelper::get_marginal_covariance(_app->get_state(),statevars);
     for(int r=0; r<6; r++) {
         for(int c=0; c<6; c++) {
             odomIinM.pose.covariance[6*r+c] = covariance_posori(r,c);
@@ -205,10 +225,8 @@ void RosVisualizer::visualize_odometry(double timestamp) {
     // TODO: this currently is an approximation since this should actually evolve over our propagation period
     // TODO: but to save time we only propagate the mean and not the uncertainty, but maybe we should try to prop the covariance?
     // TODO: can we come up with an approx covariance for the omega based on the w_hat = w_m - b_w ??
-    statevars.clear();
-    statevars.push_back(state->_imu->v());
     Eigen::Matrix<double,6,6> covariance_linang = INFINITY*Eigen::Matrix<double,6,6>::Identity();
-    covariance_linang.block(0,0,3,3) = StateHelper::get_marginal_covariance(_app->get_state(),statevars);
+    covariance_linang.block(0,0,3,3) = covariance_v;
     for(int r=0; r<6; r++) {
         for(int c=0; c<6; c++) {
             odomIinM.twist.covariance[6*r+c] = (std::isnan(covariance_linang(r,c))) ? 0 : covariance_linang(r,c);
@@ -225,6 +243,9 @@ void RosVisualizer::visualize_odometry(double timestamp) {
 
 void RosVisualizer::visualize_final() {
 
+    // Make sure the estimator does not change the state while we print it
+    std::unique_lock<std::mutex> lck = _app->lock_estimator();
+
     // Final time offset value
     if(_app->get_state()->_options.do_calib_camera_timeoffset) {
         printf(REDPURPLE "camera-imu timeoffset = %.5f\n\n" RESET,_app->get_state()->_calib_dt_CAMtoIMU->value()(0));
@@ -273,6 +294,17 @@ void RosVisualizer::visualize_final() {
     rT2 =  boost::posix_time::microsec_clock::local_time();
     printf(REDPURPLE "TIME: %.3f seconds\n\n" RESET,(rT2-rT1).total_microseconds()*1e-6);
 
+    // Print how many inertial readings came out of order
+    std::shared_ptr<ImuBuffer> imu_history = _app->get_imu_history();
+    printf(REDPURPLE "IMU: %d reordered, %d duplicates, %d dropped\n\n" RESET,
+           (int)imu_history->get_num_reordered(), (int)imu_history->get_num_duplicates(), (int)imu_history->get_num_dropped());
+
+    // Print how many feature measurements where dropped since the estimator fell too far behind our trackers
+    printf(REDPURPLE "FEATS: %d measurements dropped\n\n" RESET, (int)_app->get_track_feat()->get_feature_database()->get_num_dropped());
+
+    // Print how long the tasks of our trackers took
+    _app->get_task_pool()->print_timing();
+
 }
 
 
@@ -761,8 +793,8 @@ void RosVisualizer::publish_keyframe_information() {
 
     // Get historical feature information
     std::unordered_map<size_t, Eigen::Vector3d> hist_feat_posinG;
-    std::unordered_map<size_t, std::unordered_map<size_t, std::vector<Eigen::VectorXf>>> hist_feat_uvs;
-    std::unordered_map<size_t, std::unordered_map<size_t, std::vector<Eigen::VectorXf>>> hist_feat_uvs_norm;
+    std::unordered_map<size_t, std::unordered_map<size_t, std::vector<Eigen::Vector2f>>> hist_feat_uvs;
+    std::unordered_map<size_t, std::unordered_map<size_t, std::vector<Eigen::Vector2f>>> hist_feat_uvs_norm;
     std::unordered_map<size_t, std::unordered_map<size_t, std::vector<double>>> hist_feat_timestamps;
     _app->hist_get_features(hist_feat_posinG, hist_feat_uvs, hist_feat_uvs_norm, hist_feat_timestamps);
 
@@ -784,8 +816,8 @@ void RosVisualizer::publish_keyframe_information() {
         // Get this feature information
         size_t featid = feattimes.first;
         size_t index = (size_t)std::distance(feattimes.second.at(0).begin(), iter);
-        Eigen::VectorXf uv = hist_feat_uvs.at(featid).at(0).at(index);
-        Eigen::VectorXf uv_n = hist_feat_uvs_norm.at(featid).at(0).at(index);
+        Eigen::Vector2f uv = hist_feat_uvs.at(featid).at(0).at(index);
+        Eigen::Vector2f uv_n = hist_feat_uvs_norm.at(featid).at(0).at(index);
         Eigen::Vector3d pFinG = hist_feat_posinG.at(featid);
 
         // Push back 3d point
@@ -41,6 +41,14 @@ VioManager::VioManager(VioManagerOptions& params_) {
 
     // Nice debug
     this->params = params_;
+    if(params.use_async_pipeline && !params.use_lockfree_feed) {
+        printf(YELLOW "[PIPELINE]: asynchronous pipeline requires the lock-free feed, enabling it...\n" RESET);
+        params.use_lockfree_feed = true;
+    }
+    if(params.use_async_pipeline && !params.use_imu_rate_output) {
+        printf(YELLOW "[PIPELINE]: asynchronous pipeline requires the imu rate output for odometry, enabling it...\n" RESET);
+        params.use_imu_rate_output = true;
+    }
     params.print_estimator();
     params.print_noise();
     params.print_state();
@@ -102,6 +110,9 @@ VioManager::VioManager(VioManagerOptions& params_) {
     //===================================================================================
 
 
+    // Our pool of threads that all trackers will share
+    taskpool = std::make_shared<TaskPool>(params.num_task_threads, params.task_pool_cpus);
+
     // Lets make a feature extractor
     if(params.use_klt) {
         trackFEATS = new TrackKLT(params.num_pts,state->_options.max_aruco_features,params.fast_threshold,params.grid_x,params.grid_y,params.min_px_dist);
@@ -117,41 +128,114 @@ VioManager::VioManager(VioManagerOptions& params_) {
         trackARUCO->set_calibration(params.camera_intrinsics, params.camera_fisheye);
     }
 
+    // Have our trackers use the shared pool
+    trackFEATS->set_task_pool(taskpool);
+    if(trackARUCO != nullptr) {
+        trackARUCO->set_task_pool(taskpool);
+    }
+
+    // If enabled, our trackers will undistort points with a lookup table of each camera
+    if(params.use_undistort_lut) {
+        trackFEATS->set_undistort_lut(params.camera_wh, params.undistort_lut_step, params.undistort_lut_tolerance);
+        if(trackARUCO != nullptr) {
+            trackARUCO->set_undistort_lut(params.camera_wh, params.undistort_lut_step, params.undistort_lut_tolerance);
+        }
+    }
+
+    // If enabled, our trackers will send their observations to the feature database through lock-free rings
+    if(params.use_lockfree_feed) {
+        trackFEATS->get_feature_database()->enable_observation_rings(state->_options.num_cameras, params.lockfree_feed_size);
+        if(trackARUCO != nullptr) {
+            trackARUCO->get_feature_database()->enable_observation_rings(state->_options.num_cameras, params.lockfree_feed_size);
+        }
+    }
+
+    // History of inertial readings that is shared by everything that needs them
+    imu_history = std::make_shared<ImuBuffer>((size_t)std::max(params.imu_history_size,2));
+
     // Initialize our state propagator
-    propagator = new Propagator(params.imu_noises, params.gravity);
+    propagator = new Propagator(params.imu_noises, params.gravity, imu_history);
+
+    // If enabled, we will also publish the pose at the rate of the IMU from its own thread
+    if(params.use_imu_rate_output) {
+        fastprop = std::make_shared<FastPropagator>(params.gravity, params.state_options.imu_avg, (size_t)params.imu_history_size);
+    }
 
     // Our state initialize
-    initializer = new InertialInitializer(params.gravity,params.init_window_time,params.init_imu_thresh);
+    initializer = new InertialInitializer(params.gravity,params.init_window_time,params.init_imu_thresh,imu_history);
 
     // Make the updater!
     updaterMSCKF = new UpdaterMSCKF(params.msckf_options,params.featinit_options);
+    updaterMSCKF->set_task_pool(taskpool);
     updaterSLAM = new UpdaterSLAM(params.slam_options,params.aruco_options,params.featinit_options);
 
     // If we are using zero velocity updates, then create the updater
     if(params.try_zupt) {
-        updaterZUPT = new UpdaterZeroVelocity(params.zupt_options,params.imu_noises,params.gravity,params.zupt_max_velocity,params.zupt_noise_multiplier);
+        updaterZUPT = new UpdaterZeroVelocity(params.zupt_options,params.imu_noises,params.gravity,params.zupt_max_velocity,params.zupt_noise_multiplier,imu_history);
+    }
+
+    // Finally start our estimator thread if we are running the pipeline asynchronously
+    if(params.use_async_pipeline) {
+        pipeline_thread = std::thread(&VioManager::estimator_loop, this);
     }
 
 }
 
 
 
+VioManager::~VioManager() {
 
-void VioManager::feed_measurement_imu(double timestamp, Eigen::Vector3d wm, Eigen::Vector3d am) {
+    // Tell our estimator thread to stop once it has finished all queued frames
+    {
+        std::unique_lock<std::mutex> lck(mtx_pipeline);
+        pipeline_stop = true;
+    }
+    cv_pipeline.notify_all();
+    if(pipeline_thread.joinable()) {
+        pipeline_thread.join();
+    }
 
-    // Push back to our propagator
-    propagator->feed_imu(timestamp,wm,am);
+}
 
-    // Push back to our initializer
-    if(!is_initialized_vio) {
-        initializer->feed_imu(timestamp, wm, am);
+
+
+
+void VioManager::feed_measurement_imu(double timestamp, Eigen::Vector3d wm, Eigen::Vector3d am) {
+
+    // Our high rate output gets all readings right away, so it does not wait on the estimator
+    if(fastprop != nullptr) {
+        Propagator::IMUDATA data;
+        data.timestamp = timestamp;
+        data.wm = wm;
+        data.am = am;
+        fastprop->feed_imu(data);
     }
 
-    // Push back to the zero velocity updater if we have it
-    if(updaterZUPT != nullptr) {
-        updaterZUPT->feed_imu(timestamp, wm, am);
+    // If we are pipelined, then just buffer it until the estimator gets to the frames after it
+    if(params.use_async_pipeline) {
+        std::unique_lock<std::mutex> lck(mtx_imu);
+        Propagator::IMUDATA data;
+        data.timestamp = timestamp;
+        data.wm = wm;
+        data.am = am;
+        imu_buffer.push_back(data);
+        imu_count_fed++;
+        return;
     }
 
+    // Else directly pass it to the estimator
+    feed_imu_internal(timestamp, wm, am);
+
+}
+
+
+
+void VioManager::feed_imu_internal(double timestamp, const Eigen::Vector3d &wm, const Eigen::Vector3d &am) {
+
+    // Push back to our propagator
+    // NOTE: the initializer and zero velocity updater read from the same history
+    propagator->feed_imu(timestamp,wm,am);
+
 }
 
 
@@ -160,104 +244,99 @@ void VioManager::feed_measurement_imu(double timestamp, Eigen::Vector3d wm, Eige
 
 void VioManager::feed_measurement_monocular(double timestamp, cv::Mat& img0, size_t cam_id) {
 
-    // Start timing
-    rT1 =  boost::posix_time::microsec_clock::local_time();
+    // Track this single camera by itself
+    std::vector<cv::Mat> imgs = {img0};
+    feed_measurement_cameras(timestamp, imgs, {cam_id}, {});
+    img0 = imgs.at(0);
 
-    // Downsample if we are downsampling
-    if(params.downsample_cameras) {
-        cv::Mat img0_temp;
-        cv::pyrDown(img0,img0_temp,cv::Size(img0.cols/2.0,img0.rows/2.0));
-        img0 = img0_temp.clone();
-    }
+}
 
-    // Check if we should do zero-velocity, if so update the state with it
-    if(is_initialized_vio && updaterZUPT != nullptr) {
-        did_zupt_update = updaterZUPT->try_update(state, timestamp);
-        if(did_zupt_update) {
-            cv::Mat img_outtemp0;
-            cv::cvtColor(img0, img_outtemp0, CV_GRAY2RGB);
-            bool is_small = (std::min(img0.cols,img0.rows) < 400);
-            auto txtpt = (is_small)? cv::Point(10,30) : cv::Point(30,60);
-            cv::putText(img_outtemp0, "zvup active", txtpt, cv::FONT_HERSHEY_COMPLEX_SMALL, (is_small)? 1.0 : 2.0, cv::Scalar(0,0,255),3);
-            zupt_image = img_outtemp0.clone();
-            return;
-        }
-    }
 
-    // Feed our trackers
-    trackFEATS->feed_monocular(timestamp, img0, cam_id);
+void VioManager::feed_measurement_stereo(double timestamp, cv::Mat& img0, cv::Mat& img1, size_t cam_id0, size_t cam_id1) {
 
-    // If aruoc is avalible, the also pass to it
-    if(trackARUCO != nullptr) {
-        trackARUCO->feed_monocular(timestamp, img0, cam_id);
-    }
-    rT2 =  boost::posix_time::microsec_clock::local_time();
+    // Assert we have good ids
+    assert(cam_id0!=cam_id1);
 
-    // If we do not have VIO initialization, then try to initialize
-    // TODO: Or if we are trying to reset the system, then do that here!
-    if(!is_initialized_vio) {
-        is_initialized_vio = try_to_initialize();
-        if(!is_initialized_vio) return;
+    // Track as a stereo pair, if we are not doing binocular
+    std::vector<cv::Mat> imgs = {img0, img1};
+    std::vector<std::pair<size_t,size_t>> stereo_pairs;
+    if(params.use_stereo) {
+        stereo_pairs.push_back({cam_id0, cam_id1});
     }
+    feed_measurement_cameras(timestamp, imgs, {cam_id0, cam_id1}, stereo_pairs);
+    img0 = imgs.at(0);
+    img1 = imgs.at(1);
 
-    // Call on our propagate and update function
-    do_feature_propagate_update(timestamp);
+}
 
 
+void VioManager::feed_measurement_multi(double timestamp, std::vector<cv::Mat> &imgs, const std::vector<size_t> &cam_ids) {
+
+    // Assert we have an id for each image
+    assert(imgs.size()==cam_ids.size());
+
+    // Use our configured stereo pairs, if we are not doing binocular
+    std::vector<std::pair<size_t,size_t>> stereo_pairs;
+    if(params.use_stereo) {
+        stereo_pairs = params.stereo_pairs;
+    }
+    feed_measurement_cameras(timestamp, imgs, cam_ids, stereo_pairs);
+
 }
 
 
-void VioManager::feed_measurement_stereo(double timestamp, cv::Mat& img0, cv::Mat& img1, size_t cam_id0, size_t cam_id1) {
+void VioManager::feed_measurement_cameras(double timestamp, std::vector<cv::Mat> &imgs, const std::vector<size_t> &cam_ids,
+                                          const std::vector<std::pair<size_t,size_t>> &stereo_pairs) {
 
     // Start timing
-    rT1 =  boost::posix_time::microsec_clock::local_time();
-
-    // Assert we have good ids
-    assert(cam_id0!=cam_id1);
+    boost::posix_time::ptime rT_track0 =  boost::posix_time::microsec_clock::local_time();
 
     // Downsample if we are downsampling
+    // NOTE: the downsampled image is already a new buffer, so there is no need to clone it
     if(params.downsample_cameras) {
-        cv::Mat img0_temp, img1_temp;
-        cv::pyrDown(img0,img0_temp,cv::Size(img0.cols/2.0,img0.rows/2.0));
-        cv::pyrDown(img1,img1_temp,cv::Size(img1.cols/2.0,img1.rows/2.0));
-        img0 = img0_temp.clone();
-        img1 = img1_temp.clone();
+        for(auto &img : imgs) {
+            cv::Mat img_temp;
+            cv::pyrDown(img,img_temp,cv::Size(img.cols/2.0,img.rows/2.0));
+            img = img_temp;
+        }
     }
 
     // Check if we should do zero-velocity, if so update the state with it
-    if(is_initialized_vio && updaterZUPT != nullptr) {
-        did_zupt_update = updaterZUPT->try_update(state, timestamp);
-        if(did_zupt_update) {
-            cv::Mat img_outtemp0, img_outtemp1;
-            cv::cvtColor(img0, img_outtemp0, CV_GRAY2RGB);
-            cv::cvtColor(img1, img_outtemp1, CV_GRAY2RGB);
-            bool is_small = (std::min(img0.cols,img0.rows) < 400);
-            auto txtpt = (is_small)? cv::Point(10,30) : cv::Point(30,60);
-            cv::putText(img_outtemp0, "zvup active", txtpt, cv::FONT_HERSHEY_COMPLEX_SMALL, (is_small)? 1.0 : 2.0, cv::Scalar(0,0,255),3);
-            cv::putText(img_outtemp1, "zvup active", txtpt, cv::FONT_HERSHEY_COMPLEX_SMALL, (is_small)? 1.0 : 2.0, cv::Scalar(0,0,255),3);
-            cv::hconcat(img_outtemp0, img_outtemp1, zupt_image);
-            return;
+    // If we are pipelined, then the estimator thread will do this once it gets to this frame
+    std::unique_lock<std::mutex> lck(mtx_estimator, std::defer_lock);
+    if(!params.use_async_pipeline) {
+        lck.lock();
+        rT1 = rT_track0;
+        if(is_initialized_vio && updaterZUPT != nullptr) {
+            did_zupt_update = updaterZUPT->try_update(state, timestamp);
+            if(did_zupt_update) {
+                update_fast_propagator();
+                draw_zupt_image(imgs);
+                return;
+            }
         }
     }
 
-    // Feed our stereo trackers, if we are not doing binocular
-    if(params.use_stereo) {
-        trackFEATS->feed_stereo(timestamp, img0, img1, cam_id0, cam_id1);
-    } else {
-        boost::thread t_l = boost::thread(&TrackBase::feed_monocular, trackFEATS, boost::ref(timestamp), boost::ref(img0), boost::ref(cam_id0));
-        boost::thread t_r = boost::thread(&TrackBase::feed_monocular, trackFEATS, boost::ref(timestamp), boost::ref(img1), boost::ref(cam_id1));
-        t_l.join();
-        t_r.join();
-    }
+    // Feed our trackers, all cameras will be tracked in parallel
+    trackFEATS->feed_multi(timestamp, imgs, cam_ids, stereo_pairs);
 
     // If aruoc is avalible, the also pass to it
     // NOTE: binocular tracking for aruco doesn't make sense as we by default have the ids
-    // NOTE: thus we just call the stereo tracking if we are doing binocular!
     if(trackARUCO != nullptr) {
-        trackARUCO->feed_stereo(timestamp, img0, img1, cam_id0, cam_id1);
+        trackARUCO->feed_multi(timestamp, imgs, cam_ids, stereo_pairs);
+    }
+
+    // If we are pipelined, then we are done and the estimator thread will take it from here
+    if(params.use_async_pipeline) {
+        enqueue_frame(timestamp, imgs, rT_track0, boost::posix_time::microsec_clock::local_time());
+        return;
     }
     rT2 =  boost::posix_time::microsec_clock::local_time();
 
+    // Insert all observations our trackers have published for this frame
+    // After this, the feature database will not change until the next frame (other then our own cleanup)
+    ingest_observations(timestamp);
+
     // If we do not have VIO initialization, then try to initialize
     // TODO: Or if we are trying to reset the system, then do that here!
     if(!is_initialized_vio) {
@@ -274,6 +353,13 @@ void VioManager::feed_measurement_stereo(double timestamp, cv::Mat& img0, cv::Ma
 
 void VioManager::feed_measurement_simulation(double timestamp, const std::vector<int> &camids, const std::vector<std::vector<std::pair<size_t,Eigen::VectorXf>>> &feats) {
 
+    // The simulated tracker is always run synchronously
+    // Thus if we are pipelined, we directly pass all buffered inertial readings to the estimator
+    std::unique_lock<std::mutex> lck(mtx_estimator);
+    if(params.use_async_pipeline) {
+        forward_imu(std::numeric_limits<size_t>::max());
+    }
+
     // Start timing
     rT1 =  boost::posix_time::microsec_clock::local_time();
 
@@ -283,6 +369,13 @@ void VioManager::feed_measurement_simulation(double timestamp, const std::vector
         //delete trackFEATS; //(fix this error in the future)
         trackFEATS = new TrackSIM(state->_options.max_aruco_features);
         trackFEATS->set_calibration(params.camera_intrinsics, params.camera_fisheye);
+        trackFEATS->set_task_pool(taskpool);
+        if(params.use_undistort_lut) {
+            trackFEATS->set_undistort_lut(params.camera_wh, params.undistort_lut_step, params.undistort_lut_tolerance);
+        }
+        if(params.use_lockfree_feed) {
+            trackFEATS->get_feature_database()->enable_observation_rings(state->_options.num_cameras, params.lockfree_feed_size);
+        }
         printf(RED "[SIM]: casting our tracker to a TrackSIM object!\n" RESET);
     }
 
@@ -290,6 +383,7 @@ void VioManager::feed_measurement_simulation(double timestamp, const std::vector
     if(is_initialized_vio && updaterZUPT != nullptr) {
         did_zupt_update = updaterZUPT->try_update(state, timestamp);
         if(did_zupt_update) {
+            update_fast_propagator();
             int max_width = -1;
             int max_height = -1;
             for(auto &pair : params.camera_wh) {
@@ -319,6 +413,9 @@ void VioManager::feed_measurement_simulation(double timestamp, const std::vector
     trackSIM->feed_measurement_simulation(timestamp, camids, feats);
     rT2 =  boost::posix_time::microsec_clock::local_time();
 
+    // Insert all observations our trackers have published for this frame
+    ingest_observations(timestamp);
+
     // If we do not have VIO initialization, then return an error
     if(!is_initialized_vio) {
         printf(RED "[SIM]: your vio system should already be initialized before simulating features!!!\n" RESET);
@@ -378,6 +475,7 @@ bool VioManager::try_to_initialize() {
     printf(GREEN "[INIT]: velocity = %.4f, %.4f, %.4f\n" RESET,state->_imu->vel()(0),state->_imu->vel()(1),state->_imu->vel()(2));
     printf(GREEN "[INIT]: bias accel = %.4f, %.4f, %.4f\n" RESET,state->_imu->bias_a()(0),state->_imu->bias_a()(1),state->_imu->bias_a()(2));
     printf(GREEN "[INIT]: position = %.4f, %.4f, %.4f\n" RESET,state->_imu->pos()(0),state->_imu->pos()(1),state->_imu->pos()(2));
+    update_fast_propagator();
     return true;
 
 }
@@ -386,7 +484,6 @@ bool VioManager::try_to_initialize() {
 
 void VioManager::do_feature_propagate_update(double timestamp) {
 
-
     //===================================================================================
     // State propagation, and clone augmentation
     //===================================================================================
@@ -407,6 +504,7 @@ void VioManager::do_feature_propagate_update(double timestamp) {
     // We can start processing things when we have at least 5 clones since we can start triangulating things...
     if((int)state->_clones_IMU.size() < std::min(state->_options.max_clone_size,5)) {
         printf("waiting for enough clone states (%d of %d)....\n",(int)state->_clones_IMU.size(),std::min(state->_options.max_clone_size,5));
+        update_fast_propagator();
         return;
     }
 
@@ -619,6 +717,9 @@ void VioManager::do_feature_propagate_update(double timestamp) {
     }
     rT7 =  boost::posix_time::microsec_clock::local_time();
 
+    // Our high rate output can now integrate from this updated state
+    update_fast_propagator();
+
 
     //===================================================================================
     // Debug info, and stats tracking
@@ -708,6 +809,241 @@ void VioManager::do_feature_propagate_update(double timestamp) {
 }
 
 
+void VioManager::update_fast_propagator() {
+
+    // Nothing to do if we do not have a high rate output
+    if(fastprop == nullptr)
+        return;
+
+    // The imu state is at the time offset it was last propagated with, which the update might have changed since
+    // If we just did a zero velocity update, then our zero velocity updater was the last to move it forward
+    double t_off = state->_calib_dt_CAMtoIMU->value()(0);
+    double t_off_prop;
+    if(did_zupt_update && updaterZUPT != nullptr) {
+        if(updaterZUPT->get_last_prop_time_offset(t_off_prop))
+            t_off = t_off_prop;
+    } else if(propagator->get_last_prop_time_offset(t_off_prop)) {
+        t_off = t_off_prop;
+    }
+
+    // Pass it our current imu state, at its time in the IMU clock
+    FastPropagator::StateSnapshot snapshot;
+    snapshot.timestamp = state->_timestamp + t_off;
+    snapshot.q_GtoI = state->_imu->quat();
+    snapshot.p_IinG = state->_imu->pos();
+    snapshot.v_IinG = state->_imu->vel();
+    snapshot.bg = state->_imu->bias_g();
+    snapshot.ba = state->_imu->bias_a();
+    snapshot.cov_posori = StateHelper::get_marginal_covariance(state, {state->_imu->pose()->p(), state->_imu->pose()->q()});
+    snapshot.cov_v = StateHelper::get_marginal_covariance(state, {state->_imu->v()});
+    fastprop->set_state(snapshot);
+
+}
+
+
+
+void VioManager::ingest_observations(double timestamp) {
+
+    // Nothing to do if our trackers directly insert into their feature database
+    if(!params.use_lockfree_feed)
+        return;
+
+    // If we are pipelined, the estimator might have changed the calibration after these where tracked
+    // Our trackers now have the calibration they would have had if we where synchronous, so use it to re-normalize
+    if(params.use_async_pipeline && state->_options.do_calib_camera_intrinsics) {
+        trackFEATS->get_feature_database()->ingest_observations(timestamp, [this](std::vector<ObservationRing::Observation> &obs) {
+            trackFEATS->normalize_observations(obs);
+        });
+        if(trackARUCO != nullptr) {
+            trackARUCO->get_feature_database()->ingest_observations(timestamp, [this](std::vector<ObservationRing::Observation> &obs) {
+                trackARUCO->normalize_observations(obs);
+            });
+        }
+        return;
+    }
+
+    // Insert into each of our databases
+    trackFEATS->get_feature_database()->ingest_observations(timestamp);
+    if(trackARUCO != nullptr) {
+        trackARUCO->get_feature_database()->ingest_observations(timestamp);
+    }
+
+}
+
+
+
+void VioManager::forward_imu(size_t imu_count) {
+
+    // Grab all readings the estimator should have
+    std::vector<Propagator::IMUDATA> imu_new;
+    {
+        std::unique_lock<std::mutex> lck(mtx_imu);
+        while(imu_count_forwarded < imu_count && !imu_buffer.empty()) {
+            imu_new.push_back(imu_buffer.front());
+            imu_buffer.pop_front();
+            imu_count_forwarded++;
+        }
+    }
+
+    // Pass them to the estimator in the order they where fed
+    for(const auto &data : imu_new) {
+        feed_imu_internal(data.timestamp, data.wm, data.am);
+    }
+
+}
+
+
+
+void VioManager::enqueue_frame(double timestamp, const std::vector<cv::Mat> &imgs,
+                               const boost::posix_time::ptime &rT_track0, const boost::posix_time::ptime &rT_track1) {
+
+    // Create our frame, we only need to keep the images if we will draw the zero velocity image
+    PipelineFrame frame;
+    frame.timestamp = timestamp;
+    if(updaterZUPT != nullptr) {
+        for(const auto &img : imgs) {
+            frame.imgs.push_back(img.clone());
+        }
+    }
+    frame.rT_track0 = rT_track0;
+    frame.rT_track1 = rT_track1;
+
+    // The estimator should use all inertial readings we have been fed up to now
+    {
+        std::unique_lock<std::mutex> lck(mtx_imu);
+        frame.imu_count = imu_count_fed;
+    }
+
+    // Wait till there is space in our queue, or drop the oldest frame if we are allowed to
+    // The observations of a dropped frame are still in the rings, so the next frame will throw them away
+    std::unique_lock<std::mutex> lck(mtx_pipeline);
+    size_t max_frames = (size_t)std::max(1, params.async_queue_size);
+    double discard_until = -INFINITY;
+    while(pipeline_frames.size() >= max_frames) {
+        if(params.async_drop_frames) {
+            printf(YELLOW "[PIPELINE]: estimator is behind, dropping frame %.3f\n" RESET, pipeline_frames.front().timestamp);
+            discard_until = std::max(discard_until, pipeline_frames.front().timestamp);
+            pipeline_frames.pop_front();
+            pipeline_num_dropped++;
+        } else {
+            cv_pipeline.wait(lck);
+        }
+    }
+    if(pipeline_frames.empty()) {
+        frame.discard_until = std::max(frame.discard_until, discard_until);
+    } else {
+        pipeline_frames.front().discard_until = std::max(pipeline_frames.front().discard_until, discard_until);
+    }
+    pipeline_frames.push_back(frame);
+    lck.unlock();
+    cv_pipeline.notify_all();
+
+}
+
+
+
+void VioManager::estimator_loop() {
+
+    while(true) {
+
+        // Wait for the next tracked frame, we only stop once all frames have been processed
+        PipelineFrame frame;
+        {
+            std::unique_lock<std::mutex> lck(mtx_pipeline);
+            cv_pipeline.wait(lck, [this] { return pipeline_stop || !pipeline_frames.empty(); });
+            if(pipeline_frames.empty()) {
+                return;
+            }
+            frame = pipeline_frames.front();
+            pipeline_frames.pop_front();
+        }
+        cv_pipeline.notify_all();
+
+        // Start timing, we shift the tracking time so our statistics are still per-stage
+        std::unique_lock<std::mutex> lck(mtx_estimator);
+        rT2 =  boost::posix_time::microsec_clock::local_time();
+        rT1 = rT2 - (frame.rT_track1 - frame.rT_track0);
+
+        // Throw away the observations of any frames that where dropped before this one
+        if(frame.discard_until > -INFINITY) {
+            trackFEATS->get_feature_database()->discard_observations(frame.discard_until);
+            if(trackARUCO != nullptr) {
+                trackARUCO->get_feature_database()->discard_observations(frame.discard_until);
+            }
+        }
+
+        // Get the inertial readings that where fed before this frame
+        forward_imu(frame.imu_count);
+
+        // Check if we should do zero-velocity, if so update the state with it
+        // The synchronous feed would not have tracked this frame, so we also throw away its observations
+        bool did_zupt = false;
+        if(is_initialized_vio && updaterZUPT != nullptr) {
+            did_zupt_update = updaterZUPT->try_update(state, frame.timestamp);
+            did_zupt = did_zupt_update;
+            if(did_zupt_update) {
+                trackFEATS->get_feature_database()->discard_observations(frame.timestamp);
+                if(trackARUCO != nullptr) {
+                    trackARUCO->get_feature_database()->discard_observations(frame.timestamp);
+                }
+                update_fast_propagator();
+                draw_zupt_image(frame.imgs);
+            }
+        }
+
+        // Get the feature observations that where tracked up to this frame
+        if(!did_zupt) {
+            ingest_observations(frame.timestamp);
+        }
+
+        // If we do not have VIO initialization, then try to initialize
+        if(!did_zupt && !is_initialized_vio) {
+            is_initialized_vio = try_to_initialize();
+        }
+
+        // Call on our propagate and update function
+        if(!did_zupt && is_initialized_vio) {
+            do_feature_propagate_update(frame.timestamp);
+        }
+        lck.unlock();
+
+        // Record how long each stage took
+        boost::posix_time::ptime rT_done =  boost::posix_time::microsec_clock::local_time();
+        std::unique_lock<std::mutex> lck_pipeline(mtx_pipeline);
+        pipeline_time_track = (frame.rT_track1-frame.rT_track0).total_microseconds() * 1e-6;
+        pipeline_time_queue = (rT2-frame.rT_track1).total_microseconds() * 1e-6;
+        pipeline_time_update = (rT_done-rT2).total_microseconds() * 1e-6;
+
+    }
+
+}
+
+
+
+void VioManager::draw_zupt_image(const std::vector<cv::Mat> &imgs) {
+
+    // Nothing to draw if we do not have the images
+    if(imgs.empty())
+        return;
+
+    // Draw the text on each image and append it to the right of the last
+    bool is_small = (std::min(imgs.at(0).cols,imgs.at(0).rows) < 400);
+    auto txtpt = (is_small)? cv::Point(10,30) : cv::Point(30,60);
+    for(size_t n=0; n<imgs.size(); n++) {
+        cv::Mat img_outtemp;
+        cv::cvtColor(imgs.at(n), img_outtemp, CV_GRAY2RGB);
+        cv::putText(img_outtemp, "zvup active", txtpt, cv::FONT_HERSHEY_COMPLEX_SMALL, (is_small)? 1.0 : 2.0, cv::Scalar(0,0,255),3);
+        if(n == 0) {
+            zupt_image = img_outtemp.clone();
+        } else {
+            cv::hconcat(zupt_image, img_outtemp, zupt_image);
+        }
+    }
+
+}
+
+
+
 void VioManager::update_keyframe_historical_information(const std::vector<Feature*> &features) {
 
 
@@ -25,6 +25,12 @@
 #include <string>
 #include <algorithm>
 #include <fstream>
+#include <deque>
+#include <limits>
+#include <mutex>
+#include <thread>
+#include <atomic>
+#include <condition_variable>
 #include <Eigen/StdVector>
 #include <boost/filesystem.hpp>
 
@@ -37,6 +43,7 @@
 #include "types/Landmark.h"
 
 #include "state/Propagator.h"
+#include "state/FastPropagator.h"
 #include "state/State.h"
 #include "state/StateHelper.h"
 #include "update/UpdaterMSCKF.h"
@@ -56,6 +63,19 @@ namespace ov_msckf {
      * This class contains the state and other algorithms needed for the MSCKF to work.
      * We feed in measurements into this class and send them to their respective algorithms.
      * If we have measurements to propagate or update with, this class will call on our state to do that.
+     *
+     * If the asynchronous pipeline is enabled, then the thread that feeds images is only used for tracking.
+     * Each tracked frame is handed to a dedicated estimator thread through a small bounded queue.
+     * If this queue is full we either block the tracking stage or drop the oldest waiting frame.
+     * Inertial readings are buffered and only handed to the estimator up to the last reading fed before each frame.
+     * Thus the output is deterministic for a given input sequence (as long as no frames are dropped).
+     * The observations of a dropped frame are thrown away, so they are never inserted with a later frame.
+     * This is not identical to a synchronous run in two cases, as the trackers run ahead of the estimator:
+     * - With zero-velocity updates, the synchronous feed skips tracking a stationary frame, while here it has already been tracked.
+     *   Its observations are thrown away once the estimator does the update, but the trackers still continue from its image.
+     * - When calibrating the camera intrinsics online, tracking (e.g. KLT and RANSAC) uses the calibration before the newest update.
+     *   Observations still waiting in the rings are re-normalized with the new calibration before the estimator inserts them.
+     * The odometry should be taken from the fast propagator (see get_fast_propagator()), so it never waits on the estimator.
      */
     class VioManager {
 
@@ -69,6 +89,11 @@ namespace ov_msckf {
          */
         VioManager(VioManagerOptions& params_);
 
+        /**
+         * @brief Destructor, will wait for our estimator thread to process all queued frames
+         */
+        ~VioManager();
+
 
         /**
          * @brief Feed function for inertial data
@@ -97,6 +122,18 @@ namespace ov_msckf {
          */
         void feed_measurement_stereo(double timestamp, cv::Mat& img0, cv::Mat& img1, size_t cam_id0, size_t cam_id1);
 
+        /**
+         * @brief Feed function for a synchronized set of any number of cameras
+         *
+         * All cameras are tracked in parallel, and we only propagate and update once for the whole set.
+         * If we are doing stereo, then the configured stereo pairs will be tracked as stereo, while all others are tracked monocular.
+         *
+         * @param timestamp Time that this set of images was collected
+         * @param imgs Grayscale images
+         * @param cam_ids Unique id of what camera each image is from
+         */
+        void feed_measurement_multi(double timestamp, std::vector<cv::Mat> &imgs, const std::vector<size_t> &cam_ids);
+
         /**
          * @brief Feed function for a synchronized simulated cameras
          * @param timestamp Time that this image was collected
@@ -111,6 +148,9 @@ namespace ov_msckf {
          */
         void initialize_with_gt(Eigen::Matrix<double,17,1> imustate) {
 
+            // Make sure our estimator is not running
+            std::unique_lock<std::mutex> lck(mtx_estimator);
+
             // Initialize the system
             state->_imu->set_value(imustate.block(1,0,16,1));
             state->_imu->set_fej(imustate.block(1,0,16,1));
@@ -135,6 +175,34 @@ namespace ov_msckf {
         }
 
 
+        /**
+         * @brief Locks the estimator so that the state can be safely read
+         *
+         * When the asynchronous pipeline is enabled, the state is changed by the estimator thread.
+         * Thus anything that reads the state, propagator, or feature databases should hold this lock while it does so.
+         * This should not be called from the thread that feeds images in the synchronous case.
+         *
+         * @return Lock on our estimator, which will be released when it goes out of scope
+         */
+        std::unique_lock<std::mutex> lock_estimator() {
+            return std::unique_lock<std::mutex>(mtx_estimator);
+        }
+
+        /**
+         * @brief Returns the latency of each of the pipeline stages for the last frame
+         * @param time_track Seconds it took to track the frame
+         * @param time_queue Seconds the frame was waiting for the estimator
+         * @param time_update Seconds it took the estimator to process the frame
+         * @param num_dropped Total number of frames we have dropped since the estimator was behind
+         */
+        void get_pipeline_timing(double &time_track, double &time_queue, double &time_update, size_t &num_dropped) {
+            std::unique_lock<std::mutex> lck(mtx_pipeline);
+            time_track = pipeline_time_track;
+            time_queue = pipeline_time_queue;
+            time_update = pipeline_time_update;
+            num_dropped = pipeline_num_dropped;
+        }
+
         /// If we are initialized or not
         bool initialized() {
             return is_initialized_vio;
@@ -165,6 +233,21 @@ namespace ov_msckf {
             return trackARUCO;
         }
 
+        /// Get the pool of threads shared by our trackers
+        std::shared_ptr<TaskPool> get_task_pool() {
+            return taskpool;
+        }
+
+        /// Get our high rate pose output (nullptr if it is not enabled), add a callback to it to get the pose at the IMU rate
+        std::shared_ptr<FastPropagator> get_fast_propagator() {
+            return fastprop;
+        }
+
+        /// Get the history of inertial readings (has the counts of out of order readings)
+        std::shared_ptr<ImuBuffer> get_imu_history() {
+            return imu_history;
+        }
+
         /// Returns 3d features used in the last update in global frame
         std::vector<Eigen::Vector3d> get_good_features_MSCKF() {
             return good_features_MSCKF;
@@ -241,8 +324,8 @@ namespace ov_msckf {
 
         /// Returns historical feature positions, and measurements times and uvs used to get its estimate.
         void hist_get_features(std::unordered_map<size_t,Eigen::Vector3d> &feat_posinG,
-                               std::unordered_map<size_t, std::unordered_map<size_t, std::vector<Eigen::VectorXf>>> &feat_uvs,
-                               std::unordered_map<size_t, std::unordered_map<size_t, std::vector<Eigen::VectorXf>>> &feat_uvs_norm,
+                               std::unordered_map<size_t, std::unordered_map<size_t, std::vector<Eigen::Vector2f>>> &feat_uvs,
+                               std::unordered_map<size_t, std::unordered_map<size_t, std::vector<Eigen::Vector2f>>> &feat_uvs_norm,
                                std::unordered_map<size_t, std::unordered_map<size_t, std::vector<double>>> &feat_timestamps) {
             feat_posinG = hist_feat_posinG;
             feat_uvs = hist_feat_uvs;
@@ -254,6 +337,80 @@ namespace ov_msckf {
     protected:
 
 
+        /**
+         * @brief Tracked frame which is waiting for the estimator stage
+         */
+        struct PipelineFrame {
+
+            /// Time that this frame was collected
+            double timestamp;
+
+            /// Images of this frame (only kept if we need them to draw the zero velocity image)
+            std::vector<cv::Mat> imgs;
+
+            /// Number of inertial readings we have been fed before this frame
+            size_t imu_count;
+
+            /// When the tracking of this frame started and ended
+            boost::posix_time::ptime rT_track0, rT_track1;
+
+            /// Time of the newest frame dropped before this one, whose observations should be thrown away
+            double discard_until = -INFINITY;
+
+        };
+
+
+        /**
+         * @brief Tracks a synchronized set of images, and then propagates and updates our state with them
+         * @param timestamp Time that this set of images was collected
+         * @param imgs Grayscale images, will be downsampled in place if we are downsampling
+         * @param cam_ids Unique id of what camera each image is from
+         * @param stereo_pairs Pairs of camera ids that should be tracked as stereo
+         */
+        void feed_measurement_cameras(double timestamp, std::vector<cv::Mat> &imgs, const std::vector<size_t> &cam_ids,
+                                      const std::vector<std::pair<size_t,size_t>> &stereo_pairs);
+
+
+        /**
+         * @brief Adds an inertial reading to the history shared by our propagator, initializer, and zero velocity updater
+         * @param timestamp Time of the inertial measurement
+         * @param wm Angular velocity
+         * @param am Linear acceleration
+         */
+        void feed_imu_internal(double timestamp, const Eigen::Vector3d &wm, const Eigen::Vector3d &am);
+
+
+        /**
+         * @brief Passes buffered inertial readings to the estimator (asynchronous pipeline only)
+         * @param imu_count Number of readings, since we started, that the estimator should have after this call
+         */
+        void forward_imu(size_t imu_count);
+
+
+        /**
+         * @brief Hands a tracked frame to our estimator thread, will block or drop frames if the queue is full
+         * @param timestamp Time that this frame was collected
+         * @param imgs Images of this frame
+         * @param rT_track0 When the tracking of this frame started
+         * @param rT_track1 When the tracking of this frame ended
+         */
+        void enqueue_frame(double timestamp, const std::vector<cv::Mat> &imgs,
+                           const boost::posix_time::ptime &rT_track0, const boost::posix_time::ptime &rT_track1);
+
+
+        /**
+         * @brief Main loop of our estimator thread, processes queued frames in order until we are stopped
+         */
+        void estimator_loop();
+
+
+        /**
+         * @brief Draws the image we display when we have done a zero velocity update
+         * @param imgs Grayscale images of the current frame, will be concatenated horizontally
+         */
+        void draw_zupt_image(const std::vector<cv::Mat> &imgs);
+
+
         /**
          * @brief This function will try to initialize the state.
          *
@@ -272,6 +429,26 @@ namespace ov_msckf {
         void do_feature_propagate_update(double timestamp);
 
 
+        /**
+         * @brief Gives the current state of the estimator to our high rate output (if we have one)
+         *
+         * This should be called each time the estimator has moved its state forward or updated it.
+         */
+        void update_fast_propagator();
+
+        /**
+         * @brief Inserts the observations our trackers have published into their feature databases
+         *
+         * This only does something if our trackers feed their databases through lock-free rings.
+         * It should be called by the estimator before it uses the feature databases for a new frame.
+         * Observations of frames newer than the given time are left for a later call.
+         * If we are pipelined and calibrating intrinsics, observations are re-normalized with the current calibration of their tracker.
+         *
+         * @param timestamp Time of the frame the estimator is about to process
+         */
+        void ingest_observations(double timestamp);
+
+
         /**
          * @brief This function will update our historical tracking information.
          * This historical information includes the best estimate of a feature in the global frame.
@@ -288,20 +465,29 @@ namespace ov_msckf {
         /// Our master state object :D
         State* state;
 
+        /// History of inertial readings shared by our propagator, initializer and zupt
+        std::shared_ptr<ImuBuffer> imu_history;
+
         /// Propagator of our state
         Propagator* propagator;
 
+        /// Integrates the newest state forward at the rate of the IMU (only if enabled)
+        std::shared_ptr<FastPropagator> fastprop;
+
         /// Our sparse feature tracker (klt or descriptor)
         TrackBase* trackFEATS = nullptr;
 
         /// Our aruoc tracker
         TrackBase* trackARUCO = nullptr;
 
+        /// Pool of threads shared by all our trackers
+        std::shared_ptr<TaskPool> taskpool;
+
         /// State initializer
         InertialInitializer* initializer;
 
         /// Boolean if we are initialized or not
-        bool is_initialized_vio = false;
+        std::atomic<bool> is_initialized_vio{false};
 
         /// Our MSCKF feature updater
         UpdaterMSCKF* updaterMSCKF;
@@ -334,10 +520,30 @@ namespace ov_msckf {
         double hist_last_marginalized_time = -1;
         std::map<double,Eigen::Matrix<double,7,1>> hist_stateinG;
         std::unordered_map<size_t, Eigen::Vector3d> hist_feat_posinG;
-        std::unordered_map<size_t, std::unordered_map<size_t, std::vector<Eigen::VectorXf>>> hist_feat_uvs;
-        std::unordered_map<size_t, std::unordered_map<size_t, std::vector<Eigen::VectorXf>>> hist_feat_uvs_norm;
+        std::unordered_map<size_t, std::unordered_map<size_t, std::vector<Eigen::Vector2f>>> hist_feat_uvs;
+        std::unordered_map<size_t, std::unordered_map<size_t, std::vector<Eigen::Vector2f>>> hist_feat_uvs_norm;
         std::unordered_map<size_t, std::unordered_map<size_t, std::vector<double>>> hist_feat_timestamps;
 
+        // Lock which is held while the estimator processes a frame
+        std::mutex mtx_estimator;
+
+        // Inertial readings that have not been handed to the estimator yet (asynchronous pipeline only)
+        std::mutex mtx_imu;
+        std::deque<Propagator::IMUDATA> imu_buffer;
+        size_t imu_count_fed = 0;
+        size_t imu_count_forwarded = 0;
+
+        // Tracked frames waiting for our estimator thread, and the per-stage timing of the last frame
+        std::mutex mtx_pipeline;
+        std::condition_variable cv_pipeline;
+        std::deque<PipelineFrame> pipeline_frames;
+        std::thread pipeline_thread;
+        bool pipeline_stop = false;
+        size_t pipeline_num_dropped = 0;
+        double pipeline_time_track = 0;
+        double pipeline_time_queue = 0;
+        double pipeline_time_update = 0;
+
 
     };
 
@@ -66,6 +66,9 @@ namespace ov_msckf {
         ///  Variance threshold on our acceleration to be classified as moving
         double init_imu_thresh = 1.0;
 
+        /// Max number of IMU readings we keep in the history shared by the propagator, initializer and zupt (20 seconds at 1kHz)
+        int imu_history_size = 20000;
+
         /// If we should try to use zero velocity update
         bool try_zupt = false;
 
@@ -81,6 +84,19 @@ namespace ov_msckf {
         /// The path to the file we will record the timing information into
         std::string record_timing_filepath = "ov_msckf_timing.txt";
 
+        /// If we should run tracking and estimation as two pipelined stages (estimator runs in its own thread)
+        /// This also enables the lock-free feed and the imu rate output, so odometry never waits on the estimator
+        bool use_async_pipeline = false;
+
+        /// Max number of tracked frames that can be waiting for the estimator
+        int async_queue_size = 2;
+
+        /// If the estimator is behind, drop the oldest waiting frame instead of blocking the tracking stage
+        bool async_drop_frames = false;
+
+        /// If we should integrate the newest state forward at the rate of the IMU in its own thread (see VioManager::get_fast_propagator())
+        bool use_imu_rate_output = false;
+
         /**
          * @brief This function will print out all estimator settings loaded.
          * This allows for visual checking that everything was loaded properly from ROS/CMD parsers.
@@ -91,11 +107,16 @@ namespace ov_msckf {
             printf("\t- dt_slam_delay: %.1f\n", dt_slam_delay);
             printf("\t- init_window_time: %.2f\n", init_window_time);
             printf("\t- init_imu_thresh: %.2f\n", init_imu_thresh);
+            printf("\t- imu_history_size: %d\n", imu_history_size);
             printf("\t- zero_velocity_update: %d\n", try_zupt);
             printf("\t- zupt_max_velocity: %.2f\n", zupt_max_velocity);
             printf("\t- zupt_noise_multiplier: %.2f\n", zupt_noise_multiplier);
             printf("\t- record timing?: %d\n", (int)record_timing_information);
             printf("\t- record timing filepath: %s\n", record_timing_filepath.c_str());
+            printf("\t- use_async_pipeline: %d\n", use_async_pipeline);
+            printf("\t- async_queue_size: %d\n", async_queue_size);
+            printf("\t- async_drop_frames: %d\n", async_drop_frames);
+            printf("\t- use_imu_rate_output: %d\n", use_imu_rate_output);
         }
 
         // NOISE / CHI2 ============================
@@ -180,6 +201,9 @@ namespace ov_msckf {
         /// If we should process two cameras are being stereo or binocular. If binocular, we do monocular feature tracking on each image.
         bool use_stereo = true;
 
+        /// Pairs of camera ids (left, right) that should be tracked as stereo when feeding many cameras at once
+        std::vector<std::pair<size_t,size_t>> stereo_pairs = {{0, 1}};
+
         /// If we should use KLT tracking, or descriptor matcher
         bool use_klt = true;
 
@@ -210,6 +234,29 @@ namespace ov_msckf {
         /// KNN ration between top two descriptor matcher which is required to be a good match
         double knn_ratio = 0.85;
 
+        /// If our trackers should send their observations to the feature database through lock-free rings (ingested once per frame by the estimator)
+        bool use_lockfree_feed = false;
+
+        /// Max number of observations of each camera that can be waiting in the lock-free rings (rounded up to a power of two)
+        /// A single frame with more observations than this can never be published and will always be dropped, so it should be well above num_pts
+        int lockfree_feed_size = 4096;
+
+        /// Number of worker threads in the task pool shared by all trackers (the feeding thread also does work)
+        int num_task_threads = 1;
+
+        /// Cpus we should pin the task pool worker threads to (empty to not pin)
+        std::vector<int> task_pool_cpus;
+
+        /// If our trackers should undistort points with a lookup table of each camera (only rebuilt when the intrinsics move past a tolerance)
+        bool use_undistort_lut = false;
+
+        /// Spacing in pixels of the undistortion lookup table grid
+        int undistort_lut_step = 4;
+
+        /// How far in pixels the intrinsics can move before an undistortion lookup table is rebuilt
+        /// Non-positive uses the measured interpolation error of each table (about 0.02 pixels for a step of 4 on EuRoC)
+        double undistort_lut_tolerance = 0;
+
         /// Parameters used by our feature initialize / triangulator
         FeatureInitializerOptions featinit_options;
 
@@ -220,8 +267,20 @@ namespace ov_msckf {
             printf("FEATURE TRACKING PARAMETERS:\n");
             printf("\t- num_pts: %d\n", num_pts);
             printf("\t- use_stereo: %d\n", use_stereo);
+            printf("\t- stereo_pairs:");
+            for(const auto &pair : stereo_pairs) printf(" (%d,%d)", (int)pair.first, (int)pair.second);
+            printf("\n");
             printf("\t- downsize aruco: %d\n", downsize_aruco);
             printf("\t- downsize cameras: %d\n", downsample_cameras);
+            printf("\t- use_lockfree_feed: %d\n", use_lockfree_feed);
+            printf("\t- lockfree_feed_size: %d\n", lockfree_feed_size);
+            printf("\t- num_task_threads: %d\n", num_task_threads);
+            printf("\t- task_pool_cpus:");
+            for(const auto &cpu : task_pool_cpus) printf(" %d", cpu);
+            printf("\n");
+            printf("\t- use_undistort_lut: %d\n", use_undistort_lut);
+            printf("\t- undistort_lut_step: %d\n", undistort_lut_step);
+            printf("\t- undistort_lut_tolerance: %.4f\n", undistort_lut_tolerance);
             featinit_options.print();
         }
 
@@ -0,0 +1,191 @@
+/*
+ * OpenVINS: An Open Platform for Visual-Inertial Research
+ * Copyright (C) 2019 Patrick Geneva
+ * Copyright (C) 2019 Kevin Eckenhoff
+ * Copyright (C) 2019 Guoquan Huang
+ * Copyright (C) 2019 OpenVINS Contributors
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "FastPropagator.h"
+
+
+
+using namespace ov_core;
+using namespace ov_msckf;
+
+
+
+
+FastPropagator::FastPropagator(Eigen::Vector3d gravity, bool imu_avg, size_t history_size)
+        : _gravity(gravity), _imu_avg(imu_avg), history(std::max(history_size, (size_t)2)) {
+    thread = std::thread(&FastPropagator::run, this);
+}
+
+
+
+FastPropagator::~FastPropagator() {
+    {
+        std::unique_lock<std::mutex> lck(mtx);
+        stop = true;
+    }
+    cv.notify_all();
+    if(thread.joinable()) {
+        thread.join();
+    }
+}
+
+
+
+void FastPropagator::run() {
+
+    std::vector<Propagator::IMUDATA> readings;
+    while(true) {
+
+        // Wait till we have new readings or a new state
+        StateSnapshot snapshot;
+        bool have_snapshot = false;
+        {
+            std::unique_lock<std::mutex> lck(mtx);
+            cv.wait(lck, [this] { return stop || !pending_imu.empty() || has_pending_state; });
+            if(stop)
+                return;
+            readings.clear();
+            readings.swap(pending_imu);
+            snapshot = pending_state;
+            have_snapshot = has_pending_state;
+            has_pending_state = false;
+        }
+
+        // Record the readings so we can re-integrate them later
+        for(const auto &data : readings) {
+            history.feed(data);
+        }
+
+        // If we have a new state, then start over from it (this will also integrate the new readings)
+        if(have_snapshot) {
+            restart(snapshot);
+            publish();
+            continue;
+        }
+
+        // Else move forward one reading at a time
+        // NOTE: late readings that are older than our current state are skipped here, but will be used after the next restart
+        if(current.timestamp < 0)
+            continue;
+        for(const auto &data : readings) {
+            if(data.timestamp <= current.timestamp)
+                continue;
+            integrate(data);
+            publish();
+        }
+
+    }
+
+}
+
+
+
+void FastPropagator::restart(const StateSnapshot &snapshot) {
+
+    // Start from the estimator state
+    current = snapshot;
+
+    // Find the reading at the time of this state
+    // If it lands between two readings we interpolate them, else we use the closest we have
+    // If we have no readings yet, then the first one we get will be used for the whole first step
+    size_t idx = history.upper_bound(current.timestamp);
+    if(history.empty()) {
+        current_imu.timestamp = -1;
+        return;
+    } else if(idx == 0) {
+        current_imu = history.at(0);
+    } else if(idx == history.size()) {
+        current_imu = history.back();
+    } else {
+        current_imu = Propagator::interpolate_data(history.at(idx-1), history.at(idx), current.timestamp);
+    }
+    current_imu.timestamp = current.timestamp;
+    current.w_hat = current_imu.wm - current.bg;
+
+    // Integrate all readings that are newer then this state
+    for(size_t i=idx; i<history.size(); i++) {
+        if(history.at(i).timestamp > current.timestamp) {
+            integrate(history.at(i));
+        }
+    }
+
+}
+
+
+
+void FastPropagator::integrate(const Propagator::IMUDATA &data) {
+
+    // Corrected imu measurements (use this reading for the whole step if we do not have one at our current time)
+    const Propagator::IMUDATA &data_minus = (current_imu.timestamp < 0) ? data : current_imu;
+    double dt = data.timestamp - current.timestamp;
+    Eigen::Vector3d w_hat = data_minus.wm - current.bg;
+    Eigen::Vector3d a_hat = data_minus.am - current.ba;
+    if(_imu_avg) {
+        w_hat = 0.5*(w_hat + data.wm - current.bg);
+        a_hat = 0.5*(a_hat + data.am - current.ba);
+    }
+
+    // Orientation: Equation (101) and (103) and of Trawny indirect TR
+    double w_norm = w_hat.norm();
+    Eigen::Matrix<double,4,4> I_4x4 = Eigen::Matrix<double,4,4>::Identity();
+    Eigen::Matrix<double,3,3> R_Gtoi = quat_2_Rot(current.q_GtoI);
+    Eigen::Matrix<double,4,4> bigO;
+    if(w_norm > 1e-20) {
+        bigO = cos(0.5*w_norm*dt)*I_4x4 + 1/w_norm*sin(0.5*w_norm*dt)*Omega(w_hat);
+    } else {
+        bigO = I_4x4 + 0.5*dt*Omega(w_hat);
+    }
+    current.q_GtoI = quatnorm(bigO*current.q_GtoI);
+
+    // Position and velocity: the acceleration in the local frame, minus global gravity
+    current.p_IinG += current.v_IinG*dt + 0.5*R_Gtoi.transpose()*a_hat*dt*dt - 0.5*_gravity*dt*dt;
+    current.v_IinG += R_Gtoi.transpose()*a_hat*dt - _gravity*dt;
+
+    // Move forward in time
+    current.timestamp = data.timestamp;
+    current.w_hat = data.wm - current.bg;
+    current_imu = data;
+
+}
+
+
+
+void FastPropagator::publish() {
+
+    // Record it as our newest state
+    {
+        std::unique_lock<std::mutex> lck(mtx_latest);
+        latest = current;
+    }
+
+    // Pass it to everybody that wants it
+    // We call them from our own copy, so a callback is able to add another one without a deadlock
+    {
+        std::unique_lock<std::mutex> lck(mtx_callbacks);
+        if(callbacks_changed) {
+            callbacks_active = callbacks;
+            callbacks_changed = false;
+        }
+    }
+    for(const auto &callback : callbacks_active) {
+        callback(current);
+    }
+
+}
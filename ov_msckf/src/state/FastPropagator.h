@@ -0,0 +1,222 @@
+/*
+ * OpenVINS: An Open Platform for Visual-Inertial Research
+ * Copyright (C) 2019 Patrick Geneva
+ * Copyright (C) 2019 Kevin Eckenhoff
+ * Copyright (C) 2019 Guoquan Huang
+ * Copyright (C) 2019 OpenVINS Contributors
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef OV_MSCKF_STATE_FAST_PROPAGATOR_H
+#define OV_MSCKF_STATE_FAST_PROPAGATOR_H
+
+
+#include <mutex>
+#include <thread>
+#include <algorithm>
+#include <vector>
+#include <functional>
+#include <condition_variable>
+
+#include "state/Propagator.h"
+#include "utils/ImuBuffer.h"
+#include "utils/quat_ops.h"
+
+
+namespace ov_msckf {
+
+
+    /**
+     * @brief Publishes the pose of the IMU at the rate of the inertial readings.
+     *
+     * The estimator only has a state at camera times, which is too slow and too late for a controller.
+     * Each time the estimator has a new state it gives us a snapshot of its IMU, and we then integrate the mean forward one reading at a time.
+     * When a new snapshot arrives we re-integrate the few readings since its time, and every later reading is a single integration step.
+     * All integration and callbacks happen in our own thread, so feeding readings never waits on the integration.
+     * Only the mean is propagated (no covariance), using the same discrete model as Propagator::predict_mean_discrete().
+     */
+    class FastPropagator {
+
+    public:
+
+        /**
+         * @brief Snapshot of the IMU state at a given time
+         */
+        struct StateSnapshot {
+
+            /// Time of this state in the IMU clock
+            double timestamp = -1;
+
+            /// Rotation from global to IMU (JPL quaternion)
+            Eigen::Matrix<double, 4, 1> q_GtoI;
+
+            /// Position of the IMU in the global frame
+            Eigen::Matrix<double, 3, 1> p_IinG;
+
+            /// Velocity of the IMU in the global frame
+            Eigen::Matrix<double, 3, 1> v_IinG;
+
+            /// Gyroscope bias
+            Eigen::Matrix<double, 3, 1> bg;
+
+            /// Accelerometer bias
+            Eigen::Matrix<double, 3, 1> ba;
+
+            /// Angular velocity of the IMU with the bias removed (zero in a snapshot from the estimator)
+            Eigen::Matrix<double, 3, 1> w_hat = Eigen::Matrix<double, 3, 1>::Zero();
+
+            /// Covariance of the position and orientation at the estimator state (this is not propagated)
+            Eigen::Matrix<double, 6, 6> cov_posori = Eigen::Matrix<double, 6, 6>::Zero();
+
+            /// Covariance of the velocity at the estimator state (this is not propagated)
+            Eigen::Matrix<double, 3, 3> cov_v = Eigen::Matrix<double, 3, 3>::Zero();
+
+        };
+
+        /// Function that is called with each new state we integrate to
+        typedef std::function<void(const StateSnapshot &)> Callback;
+
+        /**
+         * @brief Default constructor, will start our integration thread
+         * @param gravity Global gravity of the system (normally [0,0,9.81])
+         * @param imu_avg If we should average the two readings of each integration step
+         * @param history_size Max number of readings we keep to re-integrate from a new snapshot
+         */
+        FastPropagator(Eigen::Vector3d gravity, bool imu_avg, size_t history_size);
+
+        /**
+         * @brief Destructor, will stop our integration thread
+         */
+        ~FastPropagator();
+
+        /**
+         * @brief Adds a function that will be called from our thread for every new state (can also be called from a callback)
+         * @param callback Function that will get the new state
+         */
+        void add_callback(Callback callback) {
+            std::unique_lock<std::mutex> lck(mtx_callbacks);
+            callbacks.push_back(callback);
+            callbacks_changed = true;
+        }
+
+        /**
+         * @brief Passes a new inertial reading to our thread (can be called from any thread)
+         * @param data New inertial reading
+         */
+        void feed_imu(const Propagator::IMUDATA &data) {
+            {
+                std::unique_lock<std::mutex> lck(mtx);
+                pending_imu.push_back(data);
+            }
+            cv.notify_one();
+        }
+
+        /**
+         * @brief Gives us a new state of the estimator to integrate from (can be called from any thread)
+         * @param snapshot State of the IMU from the estimator
+         */
+        void set_state(const StateSnapshot &snapshot) {
+            {
+                std::unique_lock<std::mutex> lck(mtx);
+                pending_state = snapshot;
+                has_pending_state = true;
+            }
+            cv.notify_one();
+        }
+
+        /**
+         * @brief Gets the newest state we have integrated to
+         * @param snapshot The newest state
+         * @return False if we have not received a state from the estimator yet
+         */
+        bool get_latest(StateSnapshot &snapshot) {
+            std::unique_lock<std::mutex> lck(mtx_latest);
+            snapshot = latest;
+            return (latest.timestamp >= 0);
+        }
+
+    protected:
+
+        /// Main loop of our thread, integrates each new reading and calls our callbacks
+        void run();
+
+        /// Re-integrates all readings we have after the time of a new snapshot
+        void restart(const StateSnapshot &snapshot);
+
+        /// Integrates our current state forward to the time of a new reading
+        void integrate(const Propagator::IMUDATA &data);
+
+        /// Stores our current state as the newest, and passes it to all callbacks
+        void publish();
+
+        /// Global gravity
+        Eigen::Matrix<double, 3, 1> _gravity;
+
+        /// If we should average the two readings of each integration step
+        bool _imu_avg;
+
+        /// Readings we have seen, used to re-integrate from a new snapshot (only used by our thread)
+        ImuBuffer history;
+
+        /// State we are currently at (only used by our thread)
+        StateSnapshot current;
+
+        /// Reading at the time of our current state, negative time if we do not have one (only used by our thread)
+        Propagator::IMUDATA current_imu;
+
+        /// Mutex for our pending readings and pending state
+        std::mutex mtx;
+
+        /// Condition that is notified when there is something new for our thread
+        std::condition_variable cv;
+
+        /// Readings that our thread has not seen yet
+        std::vector<Propagator::IMUDATA> pending_imu;
+
+        /// New state from the estimator that our thread has not seen yet
+        StateSnapshot pending_state;
+
+        /// If we have a new state from the estimator
+        bool has_pending_state = false;
+
+        /// Mutex for our callbacks
+        std::mutex mtx_callbacks;
+
+        /// Functions that we call with each new state
+        std::vector<Callback> callbacks;
+
+        /// If a function has been added since we last copied them
+        bool callbacks_changed = false;
+
+        /// Copy of our functions that we call without holding the lock (only used by our thread)
+        std::vector<Callback> callbacks_active;
+
+        /// If our thread should stop
+        bool stop = false;
+
+        /// Mutex for the newest state
+        std::mutex mtx_latest;
+
+        /// Newest state that we have integrated to
+        StateSnapshot latest;
+
+        /// Our integration thread
+        std::thread thread;
+
+    };
+
+
+}
+
+#endif //OV_MSCKF_STATE_FAST_PROPAGATOR_H
@@ -58,9 +58,13 @@ void Propagator::propagate_and_clone(State* state, double timestamp) {
     double t_off_new = state->_calib_dt_CAMtoIMU->value()(0);
 
     // First lets construct an IMU vector of measurements we need
+    // NOTE: if we preintegrate, then most readings have already been used and we only need to finish the interval
     double time0 = state->_timestamp+last_prop_time_offset;
     double time1 = timestamp+t_off_new;
-    vector<IMUDATA> prop_data = Propagator::select_imu_readings(imu_data,time0,time1);
+    vector<IMUDATA> prop_data;
+    if(state->_options.prop_cpi_model <= 0) {
+        prop_data = Propagator::select_imu_readings(*_imu_data,time0,time1);
+    }
 
     // We are going to sum up all the state transition matrices, so we can do a single large multiplication at the end
     // Phi_summed = Phi_i*Phi_summed
@@ -99,15 +103,32 @@ void Propagator::propagate_and_clone(State* state, double timestamp) {
     if(prop_data.size() > 1) last_w = prop_data.at(prop_data.size()-2).wm - state->_imu->bias_g();
     else if(!prop_data.empty()) last_w = prop_data.at(prop_data.size()-1).wm - state->_imu->bias_g();
 
+    // Else get the whole interval in one shot from our preintegrated readings
+    if(state->_options.prop_cpi_model > 0) {
+        predict_and_compute_cpi(state, time0, time1, Phi_summed, Qd_summed, last_w);
+    }
+
     // Do the update to the covariance with our "summed" state transition and IMU noise addition...
     std::vector<Type*> Phi_order;
     Phi_order.push_back(state->_imu);
-    StateHelper::EKFPropagation(state, Phi_order, Phi_order, Phi_summed, Qd_summed);
+    StateHelper::EKFPropagation<15>(state, Phi_order, Phi_summed, Qd_summed);
 
     // Set timestamp data
     state->_timestamp = timestamp;
     last_prop_time_offset = t_off_new;
 
+    // Start preintegrating the readings after this new state
+    // NOTE: this is linearized at the state before the update, which we correct for with the bias Jacobians at the next propagation
+    if(state->_options.prop_cpi_model > 0) {
+        cpi_base = create_cpi(state);
+        cpi_base_time = time1;
+        for(const auto &snapshot : cpi_snapshots) {
+            recycle_cpi(snapshot.cpi);
+        }
+        cpi_snapshots.clear();
+        preintegrate_readings();
+    }
+
     // Now perform stochastic cloning
     StateHelper::augment_clone(state, last_w);
 
@@ -130,7 +151,7 @@ void Propagator::fast_state_propagate(State *state, double timestamp, Eigen::Mat
     // First lets construct an IMU vector of measurements we need
     double time0 = state->_timestamp+last_prop_time_offset;
     double time1 = timestamp+t_off_new;
-    vector<IMUDATA> prop_data = Propagator::select_imu_readings(imu_data,time0,time1);
+    vector<IMUDATA> prop_data = Propagator::select_imu_readings(*_imu_data,time0,time1);
 
     // Save the original IMU state
     Eigen::VectorXd orig_val = state->_imu->value();
@@ -185,7 +206,7 @@ void Propagator::fast_state_propagate(State *state, double timestamp, Eigen::Mat
 
 
 
-std::vector<Propagator::IMUDATA> Propagator::select_imu_readings(const std::vector<IMUDATA>& imu_data, double time0, double time1) {
+std::vector<Propagator::IMUDATA> Propagator::select_imu_readings(const ImuBuffer& imu_data, double time0, double time1) {
 
     // Our vector imu readings
     std::vector<Propagator::IMUDATA> prop_data;
@@ -196,9 +217,13 @@ std::vector<Propagator::IMUDATA> Propagator::select_imu_readings(const std::vect
         return prop_data;
     }
 
+    // All readings before the one just ahead of our start time can not be needed, so skip right past them
+    size_t i0 = imu_data.lower_bound(time0);
+    i0 = (i0 > 0) ? i0-1 : 0;
+
     // Loop through and find all the needed measurements to propagate with
     // Note we split measurements based on the given state time, and the update timestamp
-    for(size_t i=0; i<imu_data.size()-1; i++) {
+    for(size_t i=i0; i<imu_data.size()-1; i++) {
 
         // START OF THE INTEGRATION PERIOD
         // If the next timestamp is greater then our current state time
@@ -397,6 +422,199 @@ void Propagator::predict_and_compute(State *state, const IMUDATA data_minus, con
 }
 
 
+void Propagator::predict_and_compute_cpi(State *state, double time0, double time1,
+                                         Eigen::Matrix<double,15,15> &F, Eigen::Matrix<double,15,15> &Qd, Eigen::Vector3d &last_w) {
+
+    // Set them to zero
+    F.setZero();
+    Qd.setZero();
+
+    // If our snapshots start at this state, then take the one at the last reading before the end time
+    // We then only need the piece from it to the end time, which we interpolate with the reading after it
+    // Else we will need to preintegrate the whole interval now (e.g. first propagation, or zero velocity update moved the state)
+    std::shared_ptr<CpiBase> cpi;
+    std::vector<IMUDATA> prop_data;
+    if(cpi_base != nullptr && cpi_base_time == time0 && !cpi_snapshots.empty()
+       && cpi_snapshots.front().data.timestamp <= time1 && cpi_snapshots.back().data.timestamp >= time1) {
+        size_t j = cpi_snapshots.size()-1;
+        while(cpi_snapshots.at(j).data.timestamp > time1) {
+            j--;
+        }
+        cpi = copy_cpi(cpi_snapshots.at(j).cpi);
+        last_w = cpi_snapshots.at(j).data.wm - state->_imu->bias_g();
+        if(j+1 < cpi_snapshots.size() && cpi_snapshots.at(j).data.timestamp < time1) {
+            prop_data.push_back(cpi_snapshots.at(j).data);
+            prop_data.push_back(interpolate_data(cpi_snapshots.at(j).data, cpi_snapshots.at(j+1).data, time1));
+        }
+    } else {
+        cpi = create_cpi(state);
+        prop_data = Propagator::select_imu_readings(*_imu_data,time0,time1);
+        if(prop_data.size() > 1) last_w = prop_data.at(prop_data.size()-2).wm - state->_imu->bias_g();
+        else if(!prop_data.empty()) last_w = prop_data.at(prop_data.size()-1).wm - state->_imu->bias_g();
+    }
+    for(size_t i=0; i+1<prop_data.size(); i++) {
+        cpi->feed_IMU(prop_data.at(i).timestamp, prop_data.at(i+1).timestamp,
+                      prop_data.at(i).wm, prop_data.at(i).am, prop_data.at(i+1).wm, prop_data.at(i+1).am);
+    }
+
+    // Correct our preintegrated measurements to the current biases with their Jacobians
+    // Model 2 also depends on the orientation it was linearized at, as it removes gravity inside the preintegration
+    double DT = cpi->DT;
+    Eigen::Matrix<double,3,1> dbg = state->_imu->bias_g() - cpi->b_w_lin;
+    Eigen::Matrix<double,3,1> dba = state->_imu->bias_a() - cpi->b_a_lin;
+    Eigen::Matrix<double,3,3> R_k2k1 = exp_so3(cpi->J_q*dbg)*cpi->R_k2tau;
+    Eigen::Matrix<double,3,1> alpha = cpi->alpha_tau + cpi->J_a*dbg + cpi->H_a*dba;
+    Eigen::Matrix<double,3,1> beta = cpi->beta_tau + cpi->J_b*dbg + cpi->H_b*dba;
+    Eigen::Matrix<double,3,3> O_a = Eigen::Matrix<double,3,3>::Zero();
+    Eigen::Matrix<double,3,3> O_b = Eigen::Matrix<double,3,3>::Zero();
+    Eigen::Matrix<double,3,1> grav = _gravity;
+    std::shared_ptr<CpiV2> cpi_v2 = std::dynamic_pointer_cast<CpiV2>(cpi);
+    if(cpi_v2 != nullptr) {
+        Eigen::Matrix<double,3,1> dth = -log_so3(state->_imu->Rot()*quat_2_Rot(cpi->q_k_lin).transpose());
+        O_a = cpi_v2->O_a;
+        O_b = cpi_v2->O_b;
+        alpha += O_a*dth;
+        beta += O_b*dth;
+        grav.setZero();
+    }
+
+    // Compute the new state mean value
+    Eigen::Matrix<double,3,3> R_Gtoi = state->_imu->Rot();
+    Eigen::Vector4d new_q = rot_2_quat(R_k2k1*R_Gtoi);
+    Eigen::Vector3d new_v = state->_imu->vel() - grav*DT + R_Gtoi.transpose()*beta;
+    Eigen::Vector3d new_p = state->_imu->pos() + state->_imu->vel()*DT - 0.5*grav*DT*DT + R_Gtoi.transpose()*alpha;
+
+    // Get the locations of each entry of the imu state
+    int th_id = state->_imu->q()->id()-state->_imu->id();
+    int p_id = state->_imu->p()->id()-state->_imu->id();
+    int v_id = state->_imu->v()->id()-state->_imu->id();
+    int bg_id = state->_imu->bg()->id()-state->_imu->id();
+    int ba_id = state->_imu->ba()->id()-state->_imu->id();
+
+    // Now compute Jacobian of new state wrt old state
+    // The orientation parts are the same as for a single reading, just over the whole interval
+    Eigen::Matrix<double,3,3> R_lin;
+    if (state->_options.do_fej) {
+        R_lin = state->_imu->Rot_fej();
+        Eigen::Matrix<double,3,1> v_fej = state->_imu->vel_fej();
+        Eigen::Matrix<double,3,1> p_fej = state->_imu->pos_fej();
+        F.block(th_id, th_id, 3, 3) = quat_2_Rot(new_q)*R_lin.transpose();
+        F.block(v_id, th_id, 3, 3).noalias() = -skew_x(new_v-v_fej+_gravity*DT)*R_lin.transpose();
+        F.block(p_id, th_id, 3, 3).noalias() = -skew_x(new_p-p_fej-v_fej*DT+0.5*_gravity*DT*DT)*R_lin.transpose();
+    } else {
+        R_lin = R_Gtoi;
+        F.block(th_id, th_id, 3, 3) = R_k2k1;
+        F.block(v_id, th_id, 3, 3).noalias() = -R_lin.transpose()*(skew_x(beta)-O_b);
+        F.block(p_id, th_id, 3, 3).noalias() = -R_lin.transpose()*(skew_x(alpha)-O_a);
+    }
+    F.block(th_id, bg_id, 3, 3) = -cpi->J_q;
+    F.block(bg_id, bg_id, 3, 3).setIdentity();
+    F.block(v_id, v_id, 3, 3).setIdentity();
+    F.block(v_id, bg_id, 3, 3).noalias() = R_lin.transpose()*cpi->J_b;
+    F.block(v_id, ba_id, 3, 3).noalias() = R_lin.transpose()*cpi->H_b;
+    F.block(ba_id, ba_id, 3, 3).setIdentity();
+    F.block(p_id, v_id, 3, 3) = Eigen::Matrix<double, 3, 3>::Identity() * DT;
+    F.block(p_id, p_id, 3, 3).setIdentity();
+    F.block(p_id, bg_id, 3, 3).noalias() = R_lin.transpose()*cpi->J_a;
+    F.block(p_id, ba_id, 3, 3).noalias() = R_lin.transpose()*cpi->H_a;
+
+    // The preintegrated covariance is ordered [theta, bg, beta, ba, alpha] and in the frame of the state time
+    // So we just need to rotate the velocity and position parts into the global frame
+    Eigen::Matrix<double,15,15> G = Eigen::Matrix<double,15,15>::Zero();
+    G.block(th_id, 0, 3, 3).setIdentity();
+    G.block(bg_id, 3, 3, 3).setIdentity();
+    G.block(v_id, 6, 3, 3) = R_lin.transpose();
+    G.block(ba_id, 9, 3, 3).setIdentity();
+    G.block(p_id, 12, 3, 3) = R_lin.transpose();
+    Qd = G*cpi->P_meas*G.transpose();
+    Qd = 0.5*(Qd+Qd.transpose());
+
+    //Now replace imu estimate and fej with propagated values
+    Eigen::Matrix<double,16,1> imu_x = state->_imu->value();
+    imu_x.block(0,0,4,1) = new_q;
+    imu_x.block(4,0,3,1) = new_p;
+    imu_x.block(7,0,3,1) = new_v;
+    state->_imu->set_value(imu_x);
+    state->_imu->set_fej(imu_x);
+
+}
+
+
+std::shared_ptr<CpiBase> Propagator::create_cpi(State *state) {
+    std::shared_ptr<CpiBase> cpi;
+    if(state->_options.prop_cpi_model == 2) {
+        cpi = std::make_shared<CpiV2>(_noises.sigma_w, _noises.sigma_wb, _noises.sigma_a, _noises.sigma_ab, state->_options.imu_avg);
+    } else {
+        cpi = std::make_shared<CpiV1>(_noises.sigma_w, _noises.sigma_wb, _noises.sigma_a, _noises.sigma_ab, state->_options.imu_avg);
+    }
+    cpi->setLinearizationPoints(state->_imu->bias_g(), state->_imu->bias_a(), state->_imu->quat(), _gravity);
+    return cpi;
+}
+
+
+std::shared_ptr<CpiBase> Propagator::copy_cpi(const std::shared_ptr<CpiBase> &cpi) {
+    std::shared_ptr<CpiV2> cpi_v2 = std::dynamic_pointer_cast<CpiV2>(cpi);
+    if(cpi_v2 != nullptr) {
+        return std::make_shared<CpiV2>(*cpi_v2);
+    }
+    return std::make_shared<CpiV1>(*std::dynamic_pointer_cast<CpiV1>(cpi));
+}
+
+
+std::shared_ptr<CpiBase> Propagator::copy_cpi_reuse(const std::shared_ptr<CpiBase> &cpi) {
+    if(cpi_free.empty()) {
+        return copy_cpi(cpi);
+    }
+    std::shared_ptr<CpiBase> copy = cpi_free.back();
+    cpi_free.pop_back();
+    std::shared_ptr<CpiV2> cpi_v2 = std::dynamic_pointer_cast<CpiV2>(cpi);
+    std::shared_ptr<CpiV2> copy_v2 = std::dynamic_pointer_cast<CpiV2>(copy);
+    if(cpi_v2 != nullptr && copy_v2 != nullptr) {
+        *copy_v2 = *cpi_v2;
+        return copy;
+    }
+    std::shared_ptr<CpiV1> cpi_v1 = std::dynamic_pointer_cast<CpiV1>(cpi);
+    std::shared_ptr<CpiV1> copy_v1 = std::dynamic_pointer_cast<CpiV1>(copy);
+    if(cpi_v1 != nullptr && copy_v1 != nullptr) {
+        *copy_v1 = *cpi_v1;
+        return copy;
+    }
+    return copy_cpi(cpi);
+}
+
+
+void Propagator::preintegrate_readings() {
+
+    // Our first snapshot is at the state time, which we need the reading after it to interpolate
+    if(cpi_snapshots.empty()) {
+        size_t idx = _imu_data->upper_bound(cpi_base_time);
+        if(idx == 0 || idx == _imu_data->size())
+            return;
+        CpiSnapshot snapshot;
+        snapshot.data = interpolate_data(_imu_data->at(idx-1), _imu_data->at(idx), cpi_base_time);
+        snapshot.cpi = cpi_base;
+        cpi_snapshots.push_back(snapshot);
+    }
+
+    // Continue the newest snapshot with each reading after it
+    // We can not have more snapshots than our history has readings, if we do then the camera has stopped and we just wait
+    for(size_t i=_imu_data->upper_bound(cpi_snapshots.back().data.timestamp); i<_imu_data->size(); i++) {
+        if(cpi_snapshots.size() >= _imu_data->capacity())
+            break;
+        const IMUDATA &data_minus = cpi_snapshots.back().data;
+        const IMUDATA &data_plus = _imu_data->at(i);
+        if(data_plus.timestamp-data_minus.timestamp < 1e-12)
+            continue;
+        CpiSnapshot snapshot;
+        snapshot.data = data_plus;
+        snapshot.cpi = copy_cpi_reuse(cpi_snapshots.back().cpi);
+        snapshot.cpi->feed_IMU(data_minus.timestamp, data_plus.timestamp, data_minus.wm, data_minus.am, data_plus.wm, data_plus.am);
+        cpi_snapshots.push_back(snapshot);
+    }
+
+}
+
+
 void Propagator::predict_mean_discrete(State *state, double dt,
                                         const Eigen::Vector3d &w_hat1, const Eigen::Vector3d &a_hat1,
                                         const Eigen::Vector3d &w_hat2, const Eigen::Vector3d &a_hat2,
@@ -22,8 +22,14 @@
 #define OV_MSCKF_STATE_PROPAGATOR_H
 
 
+#include <memory>
+#include <vector>
+
 #include "state/StateHelper.h"
 #include "utils/quat_ops.h"
+#include "utils/ImuBuffer.h"
+#include "cpi/CpiV1.h"
+#include "cpi/CpiV2.h"
 
 
 using namespace ov_core;
@@ -38,26 +44,17 @@ namespace ov_msckf {
      * We will first select what measurements we need to propagate with.
      * We then compute the state transition matrix at each step and update the state and covariance.
      * For derivations look at @ref propagation page which has detailed equations.
+     *
+     * We can instead use continuous preintegration (CpiV1 or CpiV2) to get the whole state transition in closed form.
+     * The readings after the state time are preintegrated as they arrive, and we keep a snapshot of the preintegration at each of them.
+     * At the camera time we then just finish the last piece from the snapshot before it, which removes most of the propagation cost from the image latency.
      */
     class Propagator {
 
     public:
 
-        /**
-         * @brief Struct for a single imu measurement (time, wm, am)
-         */
-        struct IMUDATA {
-
-            /// Timestamp of the reading
-            double timestamp;
-
-            /// Gyroscope reading, angular velocity (rad/s)
-            Eigen::Matrix<double, 3, 1> wm;
-
-            /// Accelerometer reading, linear acceleration (m/s^2)
-            Eigen::Matrix<double, 3, 1> am;
-
-        };
+        /// Struct for a single imu measurement (time, wm, am)
+        typedef ImuBuffer::IMUDATA IMUDATA;
 
 
         /**
@@ -104,8 +101,9 @@ namespace ov_msckf {
          * @brief Default constructor
          * @param noises imu noise characteristics (continuous time)
          * @param gravity Global gravity of the system (normally [0,0,9.81])
+         * @param imu_data History of IMU messages that we will add to and propagate with (can be shared with others)
          */
-        Propagator(NoiseManager noises, Eigen::Vector3d gravity) : _noises(noises), _gravity(gravity) {
+        Propagator(NoiseManager noises, Eigen::Vector3d gravity, std::shared_ptr<ImuBuffer> imu_data) : _noises(noises), _imu_data(imu_data), _gravity(gravity) {
             _noises.sigma_w_2 = std::pow(_noises.sigma_w,2);
             _noises.sigma_a_2 = std::pow(_noises.sigma_a,2);
             _noises.sigma_wb_2 = std::pow(_noises.sigma_wb,2);
@@ -114,6 +112,21 @@ namespace ov_msckf {
         }
 
 
+        /**
+         * @brief Gets the time offset that our last propagation ended with
+         *
+         * The imu state is at the state time plus this offset (t_imu = t_cam + offset).
+         * This is not the current estimate of the offset if an update has changed it since.
+         *
+         * @param offset Time offset of our last propagation
+         * @return False if we have not propagated yet
+         */
+        bool get_last_prop_time_offset(double &offset) {
+            offset = last_prop_time_offset;
+            return have_last_prop_time_offset;
+        }
+
+
         /**
          * @brief Stores incoming inertial readings
          * @param timestamp Timestamp of imu reading
@@ -128,24 +141,19 @@ namespace ov_msckf {
             data.wm = wm;
             data.am = am;
 
-            // Append it to our vector
-            imu_data.emplace_back(data);
-
-            // Sort our imu data (handles any out of order measurements)
-            //std::sort(imu_data.begin(), imu_data.end(), [](const IMUDATA i, const IMUDATA j) {
-            //    return i.timestamp < j.timestamp;
-            //});
-
-            // Loop through and delete imu messages that are older then 20 seconds
-            // TODO: we should probably have more elegant logic then this
-            // TODO: but this prevents unbounded memory growth and slow prop with high freq imu
-            auto it0 = imu_data.begin();
-            while(it0 != imu_data.end()) {
-                if(timestamp-(*it0).timestamp > 20) {
-                    it0 = imu_data.erase(it0);
-                } else {
-                    it0++;
+            // Insert it into our history (this will overwrite the oldest reading once it is full)
+            // NOTE: late readings are put into their place in time, and ones with duplicate timestamps are dropped
+            if(!_imu_data->feed(data))
+                return;
+
+            // If we are preintegrating, then do it now so it is not done at the camera time
+            // NOTE: a late reading makes all snapshots after it invalid, so they are removed and preintegrated again in order
+            if(cpi_base != nullptr) {
+                while(!cpi_snapshots.empty() && cpi_snapshots.back().data.timestamp > timestamp) {
+                    recycle_cpi(cpi_snapshots.back().cpi);
+                    cpi_snapshots.pop_back();
                 }
+                preintegrate_readings();
             }
 
         }
@@ -187,12 +195,14 @@ namespace ov_msckf {
          * We use the @ref interpolate_data() function to "cut" the imu readings at the begining and end of the integration.
          * The timestamps passed should already take into account the time offset values.
          *
+         * The first reading we need is found with a binary search, so this only touches the readings inside of the interval.
+         *
          * @param imu_data IMU data we will select measurements from
          * @param time0 Start timestamp
          * @param time1 End timestamp
          * @return Vector of measurements (if we could compute them)
          */
-        static std::vector<IMUDATA> select_imu_readings(const std::vector<IMUDATA>& imu_data, double time0, double time1);
+        static std::vector<IMUDATA> select_imu_readings(const ImuBuffer& imu_data, double time0, double time1);
 
         /**
          * @brief Nice helper function that will linearly interpolate between two imu messages.
@@ -220,6 +230,19 @@ namespace ov_msckf {
     protected:
 
 
+        /**
+         * @brief Preintegration of all readings from the state time up to one of the readings
+         */
+        struct CpiSnapshot {
+
+            /// Reading this preintegration ends at
+            IMUDATA data;
+
+            /// Preintegrated measurement from the state time to this reading
+            std::shared_ptr<CpiBase> cpi;
+
+        };
+
         /// Estimate for time offset at last propagation time
         double last_prop_time_offset = -INFINITY;
         bool have_last_prop_time_offset = false;
@@ -242,6 +265,64 @@ namespace ov_msckf {
         void predict_and_compute(State *state, const IMUDATA data_minus, const IMUDATA data_plus,
                                  Eigen::Matrix<double, 15, 15> &F, Eigen::Matrix<double, 15, 15> &Qd);
 
+        /**
+         * @brief Propagates the state forward over a whole interval using a preintegrated measurement.
+         *
+         * We take the snapshot at the last reading before the end time, and only preintegrate the piece left after it.
+         * If our snapshots do not start at the state time (e.g. our first propagation), then we preintegrate the whole interval here.
+         * The preintegration is linearized at the biases (and orientation for CpiV2) before the last update, so it is first corrected with its Jacobians.
+         * We can then write the new mean, state transition, and noise covariance in closed form from the preintegrated measurement.
+         * See @cite Eckenhoff2019IJRR for details on the preintegrated measurements and their Jacobians.
+         *
+         * @param state Pointer to state
+         * @param time0 Start time of the interval (imu clock)
+         * @param time1 End time of the interval (imu clock)
+         * @param F State-transition matrix over the interval
+         * @param Qd Discrete-time noise covariance over the interval
+         * @param last_w Angular velocity at the end of the interval with bias removed
+         */
+        void predict_and_compute_cpi(State *state, double time0, double time1,
+                                     Eigen::Matrix<double, 15, 15> &F, Eigen::Matrix<double, 15, 15> &Qd, Eigen::Vector3d &last_w);
+
+        /**
+         * @brief Creates a new empty preintegration of the model we use, linearized at the current state
+         * @param state Pointer to state
+         * @return Preintegration with no readings in it
+         */
+        std::shared_ptr<CpiBase> create_cpi(State *state);
+
+        /**
+         * @brief Copies a preintegration so that it can be continued without changing the original
+         * @param cpi Preintegration we want to copy
+         * @return Copy of the preintegration
+         */
+        static std::shared_ptr<CpiBase> copy_cpi(const std::shared_ptr<CpiBase> &cpi);
+
+        /**
+         * @brief Copies a preintegration into the storage of one we no longer need, only allocating if we have none
+         * @param cpi Preintegration we want to copy
+         * @return Copy of the preintegration
+         */
+        std::shared_ptr<CpiBase> copy_cpi_reuse(const std::shared_ptr<CpiBase> &cpi);
+
+        /**
+         * @brief Gives the preintegration of a removed snapshot back, so its storage can be reused
+         * @param cpi Preintegration that is no longer needed (our base preintegration is never reused)
+         */
+        void recycle_cpi(const std::shared_ptr<CpiBase> &cpi) {
+            if(cpi != cpi_base)
+                cpi_free.push_back(cpi);
+        }
+
+        /**
+         * @brief Preintegrates all readings in our history that are after our newest snapshot
+         *
+         * If we do not have any snapshots, then we first create the one at the state time.
+         * This needs a reading after the state time, so that we can interpolate the reading at it.
+         * We keep every snapshot since the state time, up to the number of readings our history can hold.
+         */
+        void preintegrate_readings();
+
         /**
          * @brief Discrete imu mean propagation.
          *
@@ -308,11 +389,23 @@ namespace ov_msckf {
         NoiseManager _noises;
 
         /// Our history of IMU messages (time, angular, linear)
-        std::vector<IMUDATA> imu_data;
+        std::shared_ptr<ImuBuffer> _imu_data;
 
         /// Gravity vector
         Eigen::Matrix<double, 3, 1> _gravity;
 
+        /// Empty preintegration linearized at the last state we propagated to (nullptr if we do not preintegrate)
+        std::shared_ptr<CpiBase> cpi_base = nullptr;
+
+        /// Time of the last state we propagated to (imu clock), where our snapshots start from
+        double cpi_base_time = -1;
+
+        /// Snapshots of the preintegration at each reading after the state time (oldest first)
+        std::vector<CpiSnapshot> cpi_snapshots;
+
+        /// Preintegrations of removed snapshots, whose storage we reuse so we do not allocate for each reading
+        std::vector<std::shared_ptr<CpiBase>> cpi_free;
+
 
     };
 
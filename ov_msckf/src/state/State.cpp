@@ -75,24 +75,132 @@ State::State(StateOptions &options) {
         }
     }
 
+    // Allocate our covariance storage for the largest state we expect to have
+    // This is all active variables, our sliding window (plus the one new clone before marginalization), and SLAM features
+    // Note that aruco tags are not included here, but if we exceed this size the storage will just be reallocated
+    int max_size = current_id + 6*(_options.max_clone_size+1) + 3*_options.max_slam_features;
+    _Cov_arena = CovMatrix::Zero(max_size, max_size);
+    _Cov_size = current_id;
+
     // Finally initialize our covariance to small value
-    _Cov = 1e-3*Eigen::MatrixXd::Identity(current_id, current_id);
+    Cov() = (1e-3*Eigen::MatrixXd::Identity(current_id, current_id)).cast<CovScalar>();
 
     // Finally, set some of our priors for our calibration parameters
     if (_options.do_calib_camera_timeoffset) {
-        _Cov(_calib_dt_CAMtoIMU->id(),_calib_dt_CAMtoIMU->id()) = std::pow(0.01,2);
+        Cov()(_calib_dt_CAMtoIMU->id(),_calib_dt_CAMtoIMU->id()) = (CovScalar)std::pow(0.01,2);
     }
     if (_options.do_calib_camera_pose) {
         for(int i=0; i<_options.num_cameras; i++) {
-            _Cov.block(_calib_IMUtoCAM.at(i)->id(),_calib_IMUtoCAM.at(i)->id(),3,3) = std::pow(0.001,2)*Eigen::MatrixXd::Identity(3,3);
-            _Cov.block(_calib_IMUtoCAM.at(i)->id()+3,_calib_IMUtoCAM.at(i)->id()+3,3,3) = std::pow(0.01,2)*Eigen::MatrixXd::Identity(3,3);
+            Cov().block(_calib_IMUtoCAM.at(i)->id(),_calib_IMUtoCAM.at(i)->id(),3,3) = (std::pow(0.001,2)*Eigen::MatrixXd::Identity(3,3)).cast<CovScalar>();
+            Cov().block(_calib_IMUtoCAM.at(i)->id()+3,_calib_IMUtoCAM.at(i)->id()+3,3,3) = (std::pow(0.01,2)*Eigen::MatrixXd::Identity(3,3)).cast<CovScalar>();
         }
     }
     if (_options.do_calib_camera_intrinsics) {
         for(int i=0; i<_options.num_cameras; i++) {
-            _Cov.block(_cam_intrinsics.at(i)->id(),_cam_intrinsics.at(i)->id(),4,4) = std::pow(1.0,2)*Eigen::MatrixXd::Identity(4,4);
-            _Cov.block(_cam_intrinsics.at(i)->id()+4,_cam_intrinsics.at(i)->id()+4,4,4) = std::pow(0.005,2)*Eigen::MatrixXd::Identity(4,4);
+            Cov().block(_cam_intrinsics.at(i)->id(),_cam_intrinsics.at(i)->id(),4,4) = (std::pow(1.0,2)*Eigen::MatrixXd::Identity(4,4)).cast<CovScalar>();
+            Cov().block(_cam_intrinsics.at(i)->id()+4,_cam_intrinsics.at(i)->id()+4,4,4) = (std::pow(0.005,2)*Eigen::MatrixXd::Identity(4,4)).cast<CovScalar>();
+        }
+    }
+
+    // If we are using a square-root covariance, then store the factor instead
+    // Our initial covariance is diagonal, so this is just the square-root of the diagonal
+    if (_options.use_sqrt_covariance) {
+        Cov().diagonal() = Cov().diagonal().cwiseSqrt();
+    }
+}
+
+
+
+void State::cov_block(int row, int col, int rows, int cols, Eigen::Ref<CovMatrix> out) {
+
+    // Make sure this is a valid block
+    assert(out.rows() == rows && out.cols() == cols);
+    assert(row >= 0 && row + rows <= _Cov_size);
+    assert(col >= 0 && col + cols <= _Cov_size);
+
+    // Rows that are fully above the columns of the block can be directly copied
+    int num_above = std::max(0, std::min(row + rows, col) - row);
+    if (num_above > 0) {
+        out.topRows(num_above) = _Cov_arena.block(row, col, num_above, cols);
+    }
+
+    // Rows that are fully below the columns of the block are read from the transposed upper triangle
+    int row_below = std::max(row, col + cols);
+    int num_below = std::max(0, row + rows - row_below);
+    if (num_below > 0) {
+        out.bottomRows(num_below) = _Cov_arena.block(col, row_below, cols, num_below).transpose();
+    }
+
+    // All other rows overlap the diagonal, so go column by column
+    for (int r = row + num_above; r < row_below && r < row + rows; r++) {
+        for (int c = col; c < col + cols; c++) {
+            out(r - row, c - col) = (r <= c)? _Cov_arena(r, c) : _Cov_arena(c, r);
         }
     }
+
+}
+
+
+void State::cov_grow(int size) {
+
+    // Reallocate our storage if this new size does not fit
+    // We double the storage so that we do not need to do this often
+    int new_size = _Cov_size + size;
+    if (new_size > _Cov_arena.rows()) {
+        int new_capacity = std::max(new_size, 2*(int)_Cov_arena.rows());
+        printf(YELLOW "State::cov_grow() - covariance of size %d exceeds storage of %d, reallocating to %d\n" RESET,
+               new_size, (int)_Cov_arena.rows(), new_capacity);
+        _Cov_arena.conservativeResize(new_capacity, new_capacity);
+    }
+
+    // Zero the new rows and columns (old storage might have been used by a marginalized variable)
+    _Cov_arena.block(0, _Cov_size, new_size, size).setZero();
+    _Cov_arena.block(_Cov_size, 0, size, _Cov_size).setZero();
+    _Cov_size = new_size;
+
 }
 
+
+void State::cov_remove(std::vector<std::pair<int,int>> blocks) {
+
+    // Sort the blocks by their location and make sure they are valid
+    std::sort(blocks.begin(), blocks.end());
+    for (size_t i = 0; i < blocks.size(); i++) {
+        assert(blocks.at(i).first >= 0 && blocks.at(i).second >= 0);
+        assert(blocks.at(i).first + blocks.at(i).second <= _Cov_size);
+        assert(i == 0 || blocks.at(i-1).first + blocks.at(i-1).second <= blocks.at(i).first);
+    }
+
+    // Get the contiguous segments we will keep (location and size)
+    std::vector<std::pair<int,int>> keep;
+    int keep_start = 0;
+    for (const auto &block : blocks) {
+        if (block.first > keep_start)
+            keep.emplace_back(keep_start, block.first - keep_start);
+        keep_start = block.first + block.second;
+    }
+    if (keep_start < _Cov_size)
+        keep.emplace_back(keep_start, _Cov_size - keep_start);
+
+    // Our storage is column-major, so each column is contiguous in memory
+    // For each column we keep, we move each kept segment of rows up, and then move the column to the left
+    // Since we only ever move data up and left, we can process the columns in order without overwriting data we still need
+    int ld = (int)_Cov_arena.rows();
+    CovScalar *data = _Cov_arena.data();
+    int new_size = 0;
+    for (const auto &seg : keep) {
+        for (int c = seg.first; c < seg.first + seg.second; c++) {
+            CovScalar *col_old = data + (size_t)c*ld;
+            CovScalar *col_new = data + (size_t)(new_size + c - seg.first)*ld;
+            int r_new = 0;
+            for (const auto &seg_r : keep) {
+                if (col_new + r_new != col_old + seg_r.first)
+                    std::memmove(col_new + r_new, col_old + seg_r.first, sizeof(CovScalar)*seg_r.second);
+                r_new += seg_r.second;
+            }
+        }
+        new_size += seg.second;
+    }
+    _Cov_size = new_size;
+
+}
@@ -23,6 +23,8 @@
 
 
 #include <vector>
+#include <algorithm>
+#include <cstring>
 #include <unordered_map>
 
 #include "types/Type.h"
@@ -31,6 +33,7 @@
 #include "types/PoseJPL.h"
 #include "types/Landmark.h"
 #include "StateOptions.h"
+#include "utils/colors.h"
 
 using namespace ov_core;
 using namespace ov_type;
@@ -38,6 +41,22 @@ using namespace ov_type;
 
 namespace ov_msckf {
 
+    /**
+     * @brief Scalar type the state covariance is stored in.
+     *
+     * If OV_MSCKF_FLOAT_COVARIANCE is defined (see the ENABLE_FLOAT_COVARIANCE cmake option) the covariance and the large
+     * products with it are done in single precision, and the MSCKF stacks its large jacobian in it. Numerically sensitive steps such
+     * as the S^{-1} solve, chi-squared tests, the nullspace projection and the measurement compression QR are still done in double precision.
+     */
+#ifdef OV_MSCKF_FLOAT_COVARIANCE
+    typedef float CovScalar;
+#else
+    typedef double CovScalar;
+#endif
+
+    /// Dynamic sized matrix type that the state covariance is stored in
+    typedef Eigen::Matrix<CovScalar, Eigen::Dynamic, Eigen::Dynamic> CovMatrix;
+
     /**
      * @brief State of our filter
      *
@@ -80,7 +99,7 @@ namespace ov_msckf {
          * @return Size of the current covariance matrix
          */
         int max_covariance_size() {
-            return (int)_Cov.rows();
+            return _Cov_size;
         }
 
 
@@ -119,8 +138,52 @@ namespace ov_msckf {
         // This prevents a developer from thinking that the "insert clone" will actually correctly add it to the covariance
         friend class StateHelper;
 
-        /// Covariance of all active variables
-        Eigen::MatrixXd _Cov;
+        /**
+         * @brief Returns the covariance of all active variables.
+         *
+         * This is a view into the top-left corner of our preallocated covariance storage.
+         * The storage is sized from our state options at construction, so that adding and removing variables do not reallocate.
+         * If StateOptions::use_sqrt_covariance is set, this instead holds the upper-triangular factor U where P = U^T*U.
+         */
+        Eigen::Block<CovMatrix> Cov() {
+            return _Cov_arena.topLeftCorner(_Cov_size, _Cov_size);
+        }
+
+        /**
+         * @brief Gets a block of the covariance of all active variables.
+         *
+         * We only keep the upper triangular portion of our covariance valid.
+         * Thus any part of the requested block which is below the diagonal is read from its transposed location.
+         * @param row Starting row of the block
+         * @param col Starting column of the block
+         * @param rows Number of rows in the block
+         * @param cols Number of columns in the block
+         * @param out Output matrix of size rows by cols
+         */
+        void cov_block(int row, int col, int rows, int cols, Eigen::Ref<CovMatrix> out);
+
+        /**
+         * @brief Grows the active covariance, the new rows and columns are appended to the end and zeroed.
+         *
+         * If the requested size does not fit into the preallocated storage we will reallocate (and warn).
+         * @param size Number of rows and columns to append
+         */
+        void cov_grow(int size);
+
+        /**
+         * @brief Removes sets of rows and columns from the active covariance in place.
+         *
+         * All remaining rows and columns are shifted up and to the left so the covariance stays contiguous.
+         * This is done in a single pass over the covariance no matter how many blocks are removed.
+         * @param blocks Location and size of each block of rows and columns to remove (must not overlap)
+         */
+        void cov_remove(std::vector<std::pair<int,int>> blocks);
+
+        /// Preallocated storage for the covariance (only the top-left _Cov_size corner is valid)
+        CovMatrix _Cov_arena;
+
+        /// Current size of the covariance of all active variables
+        int _Cov_size = 0;
 
         /// Vector of variables
         std::vector<Type*> _variables;
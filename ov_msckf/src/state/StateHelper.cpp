@@ -66,13 +66,21 @@ void StateHelper::EKFPropagation(State *state, const std::vector<Type*> &order_N
         current_it += var->size();
     }
 
+    // If we are storing the square-root covariance, then propagate the factor instead
+    if (state->_options.use_sqrt_covariance) {
+        StateHelper::EKFPropagation_sqrt(state, order_NEW, order_OLD, Phi_id, Phi, Q);
+        return;
+    }
+
     // Loop through all our old states and get the state transition times it
     // Cov_PhiT = [ Pxx ] [ Phi' ]'
-    Eigen::MatrixXd Cov_PhiT = Eigen::MatrixXd::Zero(state->_Cov.rows(), Phi.rows());
+    CovMatrix Cov_PhiT = CovMatrix::Zero(state->Cov().rows(), Phi.rows());
+    CovMatrix Cov_var(state->Cov().rows(), 0);
     for (size_t i=0; i<order_OLD.size(); i++) {
         Type *var = order_OLD.at(i);
-        Cov_PhiT.noalias() += state->_Cov.block(0, var->id(), state->_Cov.rows(), var->size())
-                              * Phi.block(0, Phi_id[i], Phi.rows(), var->size()).transpose();
+        Cov_var.resize(state->Cov().rows(), var->size());
+        state->cov_block(0, var->id(), state->Cov().rows(), var->size(), Cov_var);
+        Cov_PhiT.noalias() += Cov_var * Phi.block(0, Phi_id[i], Phi.rows(), var->size()).transpose().cast<CovScalar>();
 
     }
 
@@ -81,27 +89,23 @@ void StateHelper::EKFPropagation(State *state, const std::vector<Type*> &order_N
     for (size_t i=0; i<order_OLD.size(); i++) {
         Type *var = order_OLD.at(i);
         Phi_Cov_PhiT.noalias() += Phi.block(0, Phi_id[i], Phi.rows(), var->size())
-                                  * Cov_PhiT.block(var->id(), 0, var->size(), Phi.rows());
+                                  * Cov_PhiT.block(var->id(), 0, var->size(), Phi.rows()).cast<double>();
     }
 
     // We are good to go!
+    // Note that we only need to write the upper triangular portion of our covariance
     int start_id = order_NEW.at(0)->id();
     int phi_size = Phi.rows();
-    int total_size = state->_Cov.rows();
-    state->_Cov.block(start_id,0,phi_size,total_size) = Cov_PhiT.transpose();
-    state->_Cov.block(0,start_id,total_size,phi_size) = Cov_PhiT;
-    state->_Cov.block(start_id,start_id,phi_size,phi_size) = Phi_Cov_PhiT;
+    int total_size = state->Cov().rows();
+    int end_size = total_size - start_id - phi_size;
+    state->Cov().block(0,start_id,start_id,phi_size) = Cov_PhiT.topRows(start_id);
+    state->Cov().block(start_id,start_id+phi_size,phi_size,end_size) = Cov_PhiT.bottomRows(end_size).transpose();
+    state->Cov().block(start_id,start_id,phi_size,phi_size) = Phi_Cov_PhiT.cast<CovScalar>();
 
     // We should check if we are not positive semi-definitate (i.e. negative diagionals is not s.p.d)
-    Eigen::VectorXd diags = state->_Cov.diagonal();
-    bool found_neg = false;
-    for(int i=0; i<diags.rows(); i++) {
-        if(diags(i) < 0.0) {
-            printf(RED "StateHelper::EKFPropagation() - diagonal at %d is %.2f\n" RESET,i,diags(i));
-            found_neg = true;
-        }
+    if (state->_options.do_diagnostics) {
+        StateHelper::check_covariance(state, "EKFPropagation");
     }
-    assert(!found_neg);
 
 }
 
@@ -114,7 +118,6 @@ void StateHelper::EKFUpdate(State *state, const std::vector<Type *> &H_order, co
     // Part of the Kalman Gain K = (P*H^T)*S^{-1} = M*S^{-1}
     assert(res.rows() == R.rows());
     assert(H.rows() == res.rows());
-    Eigen::MatrixXd M_a = Eigen::MatrixXd::Zero(state->_Cov.rows(), res.rows());
 
     // Get the location in small jacobian for each measuring variable
     int current_it = 0;
@@ -123,25 +126,33 @@ void StateHelper::EKFUpdate(State *state, const std::vector<Type *> &H_order, co
         H_id.push_back(current_it);
         current_it += meas_var->size();
     }
+    assert(H.cols() == current_it);
+
+    // If we are storing the square-root covariance, then update the factor instead
+    if (state->_options.use_sqrt_covariance) {
+        StateHelper::EKFUpdate_sqrt(state, H_order, H_id, H, res, R);
+        return;
+    }
 
     //==========================================================
     //==========================================================
-    // For each active variable find its M = P*H^T
-    for (Type *var: state->_variables) {
-        // Sum up effect of each subjacobian = K_i= \sum_m (P_im Hm^T)
-        Eigen::MatrixXd M_i = Eigen::MatrixXd::Zero(var->size(), res.rows());
-        for (size_t i = 0; i < H_order.size(); i++) {
-            Type *meas_var = H_order[i];
-            M_i.noalias() += state->_Cov.block(var->id(), meas_var->id(), var->size(), meas_var->size()) *
-                             H.block(0, H_id[i], H.rows(), meas_var->size()).transpose();
-        }
-        M_a.block(var->id(), 0, var->size(), res.rows()) = M_i;
+    // Gather only the covariance columns that the Jacobian touches
+    // This way M = P*H^T is a single GEMM over these columns instead of a loop over every state variable
+    CovMatrix P_cols(state->Cov().rows(), current_it);
+    for (size_t i = 0; i < H_order.size(); i++) {
+        state->cov_block(0, H_order[i]->id(), state->Cov().rows(), H_order[i]->size(), P_cols.middleCols(H_id[i], H_order[i]->size()));
     }
+    CovMatrix M_a(state->Cov().rows(), res.rows());
+    M_a.noalias() = P_cols * H.transpose().cast<CovScalar>();
 
     //==========================================================
     //==========================================================
-    // Get covariance of the involved terms
-    Eigen::MatrixXd P_small = StateHelper::get_marginal_covariance(state, H_order);
+    // Get covariance of the involved terms (these are just the touched rows of our gathered columns)
+    Eigen::MatrixXd P_small(current_it, current_it);
+    for (size_t i = 0; i < H_order.size(); i++) {
+        P_small.middleRows(H_id[i], H_order[i]->size()) = P_cols.middleRows(H_order[i]->id(), H_order[i]->size()).cast<double>();
+    }
+    P_cols.resize(0, 0);
 
     // Residual covariance S = H*Cov*H' + R
     Eigen::MatrixXd S(R.rows(), R.rows());
@@ -149,31 +160,113 @@ void StateHelper::EKFUpdate(State *state, const std::vector<Type *> &H_order, co
     S.triangularView<Eigen::Upper>() += R;
     //Eigen::MatrixXd S = H * P_small * H.transpose() + R;
 
-    // Invert our S (should we use a more stable method here??)
-    Eigen::MatrixXd Sinv = Eigen::MatrixXd::Identity(R.rows(), R.rows());
-    S.selfadjointView<Eigen::Upper>().llt().solveInPlace(Sinv);
-    Eigen::MatrixXd K = M_a * Sinv.selfadjointView<Eigen::Upper>();
-    //Eigen::MatrixXd K = M_a * S.inverse();
+    // Factor our S = L*L^T (should we use a more stable method here??)
+    Eigen::LLT<Eigen::MatrixXd,Eigen::Upper> llt_S = S.selfadjointView<Eigen::Upper>().llt();
 
     // Update Covariance
-    state->_Cov.triangularView<Eigen::Upper>() -= K * M_a.transpose();
-    state->_Cov = state->_Cov.selfadjointView<Eigen::Upper>();
+    // We have K*M^T = M*S^{-1}*M^T = (M*L^{-T})*(M*L^{-T})^T which is a rank-m downdate of the upper triangle
+    // Thus we never need to form the dense K or the full K*M^T temporary
+    // Note that the factorization of S is always done in double precision, only the tall solve is in the covariance precision
+    CovMatrix L_S = llt_S.matrixL().toDenseMatrix().cast<CovScalar>();
+    CovMatrix W_T = M_a.transpose();
+    L_S.triangularView<Eigen::Lower>().solveInPlace(W_T);
+    // Only the upper triangle is updated and kept valid, the lower triangle of our covariance is never read
+    state->Cov().selfadjointView<Eigen::Upper>().rankUpdate(W_T.transpose(), -1);
     //Cov -= K * M_a.transpose();
     //Cov = 0.5*(Cov+Cov.transpose());
 
     // We should check if we are not positive semi-definitate (i.e. negative diagionals is not s.p.d)
-    Eigen::VectorXd diags = state->_Cov.diagonal();
-    bool found_neg = false;
-    for(int i=0; i<diags.rows(); i++) {
-        if(diags(i) < 0.0) {
-            printf(RED "StateHelper::EKFUpdate() - diagonal at %d is %.2f\n" RESET,i,diags(i));
-            found_neg = true;
-        }
+    if (state->_options.do_diagnostics) {
+        StateHelper::check_covariance(state, "EKFUpdate");
     }
-    assert(!found_neg);
 
     // Calculate our delta and update all our active states
-    Eigen::VectorXd dx = K*res;
+    Eigen::VectorXd dx = M_a.cast<double>() * llt_S.solve(res);
+    for (size_t i = 0; i < state->_variables.size(); i++) {
+        state->_variables.at(i)->update(dx.block(state->_variables.at(i)->id(), 0, state->_variables.at(i)->size(), 1));
+    }
+
+}
+
+
+
+void StateHelper::EKFUpdateInformation(State *state, const std::vector<Type *> &H_order, const Eigen::MatrixXd &Lambda,
+                                       const Eigen::VectorXd &b) {
+
+    //==========================================================
+    //==========================================================
+    assert(Lambda.rows() == Lambda.cols());
+    assert(Lambda.rows() == b.rows());
+
+    // We can only do this if we have the covariance itself
+    if (state->_options.use_sqrt_covariance) {
+        printf(RED "StateHelper::EKFUpdateInformation() - Called with the square-root covariance enabled!\n" RESET);
+        printf(RED "StateHelper::EKFUpdateInformation() - Please use the StateHelper::EKFUpdate() function instead.\n" RESET);
+        std::exit(EXIT_FAILURE);
+    }
+
+    // Get the location in small information for each measuring variable
+    int current_it = 0;
+    std::vector<int> H_id;
+    for (Type *meas_var: H_order) {
+        H_id.push_back(current_it);
+        current_it += meas_var->size();
+    }
+    assert(Lambda.cols() == current_it);
+
+    // Gather only the covariance columns of the involved variables and their marginal covariance
+    CovMatrix P_cols(state->Cov().rows(), current_it);
+    for (size_t i = 0; i < H_order.size(); i++) {
+        state->cov_block(0, H_order[i]->id(), state->Cov().rows(), H_order[i]->size(), P_cols.middleCols(H_id[i], H_order[i]->size()));
+    }
+    Eigen::MatrixXd P_small(current_it, current_it);
+    for (size_t i = 0; i < H_order.size(); i++) {
+        P_small.middleRows(H_id[i], H_order[i]->size()) = P_cols.middleRows(H_order[i]->id(), H_order[i]->size()).cast<double>();
+    }
+
+    //==========================================================
+    //==========================================================
+    // Factor the marginal P_ss = L*L^T and compute T = I + L^T*Lambda*L
+    // Note that T always has eigenvalues larger then one so its factorization is always well conditioned
+    // If either is not positive definite, then their factors are not valid and would corrupt our state, so we should crash
+    Eigen::LLT<Eigen::MatrixXd> llt_P(P_small);
+    if (llt_P.info() != Eigen::Success) {
+        printf(RED "StateHelper::EKFUpdateInformation() - marginal covariance of the measured variables is not positive definite!\n" RESET);
+        std::exit(EXIT_FAILURE);
+    }
+    Eigen::MatrixXd L_P = llt_P.matrixL();
+    Eigen::MatrixXd T = Eigen::MatrixXd::Identity(current_it, current_it);
+    T.noalias() += L_P.transpose() * Lambda.selfadjointView<Eigen::Upper>() * L_P;
+    Eigen::LLT<Eigen::MatrixXd> llt_T(T);
+    if (llt_T.info() != Eigen::Success) {
+        printf(RED "StateHelper::EKFUpdateInformation() - information update I+L^T*Lambda*L is not positive definite!\n" RESET);
+        std::exit(EXIT_FAILURE);
+    }
+
+    // Our update is then P -= B*(I-T^{-1})*B^T with B = P(:,s)*L^{-T}
+    // We factor the small (I-T^{-1}) which is positive semi-definite with a pivoting LDLT so we can apply it as a rank update
+    Eigen::MatrixXd Y = Eigen::MatrixXd::Identity(current_it, current_it) - llt_T.solve(Eigen::MatrixXd::Identity(current_it, current_it));
+    Eigen::LDLT<Eigen::MatrixXd> ldlt_Y(0.5 * (Y + Y.transpose()));
+    Eigen::MatrixXd Z = ldlt_Y.transpositionsP().transpose() * Eigen::MatrixXd(ldlt_Y.matrixL());
+    Z = Z * ldlt_Y.vectorD().cwiseMax(0.0).cwiseSqrt().asDiagonal();
+
+    // Compute B^T = L^{-1}*P(:,s)^T in our covariance precision
+    CovMatrix B_T = P_cols.transpose();
+    P_cols.resize(0, 0);
+    CovMatrix L_P_cov = L_P.cast<CovScalar>();
+    L_P_cov.triangularView<Eigen::Lower>().solveInPlace(B_T);
+
+    // Update Covariance (only the upper triangle is updated and kept valid)
+    CovMatrix W = B_T.transpose() * Z.cast<CovScalar>();
+    state->Cov().selfadjointView<Eigen::Upper>().rankUpdate(W, -1);
+
+    // We should check if we are not positive semi-definitate (i.e. negative diagionals is not s.p.d)
+    if (state->_options.do_diagnostics) {
+        StateHelper::check_covariance(state, "EKFUpdateInformation");
+    }
+
+    // Calculate our delta and update all our active states
+    Eigen::VectorXd dx = B_T.transpose().cast<double>() * llt_T.solve(L_P.transpose() * b);
     for (size_t i = 0; i < state->_variables.size(); i++) {
         state->_variables.at(i)->update(dx.block(state->_variables.at(i)->id(), 0, state->_variables.at(i)->size(), 1));
     }
@@ -193,14 +286,35 @@ Eigen::MatrixXd StateHelper::get_marginal_covariance(State *state, const std::ve
     // Construct our return covariance
     Eigen::MatrixXd Small_cov = Eigen::MatrixXd::Zero(cov_size, cov_size);
 
+    // If we are storing the square-root covariance, then the marginal is P_ss = U(:,s)^T*U(:,s)
+    // Note that only the rows up to the last variable can be non-zero since the factor is upper-triangular
+    if (state->_options.use_sqrt_covariance) {
+        int row_max = 0;
+        for (size_t i = 0; i < small_variables.size(); i++) {
+            row_max = std::max(row_max, small_variables[i]->id() + small_variables[i]->size());
+        }
+        CovMatrix U_cols(row_max, cov_size);
+        int i_index = 0;
+        for (size_t i = 0; i < small_variables.size(); i++) {
+            U_cols.middleCols(i_index, small_variables[i]->size()) = state->Cov().block(0, small_variables[i]->id(), row_max, small_variables[i]->size());
+            i_index += small_variables[i]->size();
+        }
+        Small_cov = (U_cols.transpose() * U_cols).cast<double>();
+        return Small_cov;
+    }
+
     // For each variable, lets copy over all other variable cross terms
     // Note: this copies over itself to when i_index=k_index
     int i_index = 0;
     for (size_t i = 0; i < small_variables.size(); i++) {
         int k_index = 0;
         for (size_t k = 0; k < small_variables.size(); k++) {
-            Small_cov.block(i_index, k_index, small_variables[i]->size(), small_variables[k]->size()) =
-                    state->_Cov.block(small_variables[i]->id(), small_variables[k]->id(), small_variables[i]->size(), small_variables[k]->size());
+            if (small_variables[i]->id() <= small_variables[k]->id()) {
+                CovMatrix Cov_ik(small_variables[i]->size(), small_variables[k]->size());
+                state->cov_block(small_variables[i]->id(), small_variables[k]->id(), small_variables[i]->size(), small_variables[k]->size(), Cov_ik);
+                Small_cov.block(i_index, k_index, small_variables[i]->size(), small_variables[k]->size()) = Cov_ik.cast<double>();
+                Small_cov.block(k_index, i_index, small_variables[k]->size(), small_variables[i]->size()) = Cov_ik.transpose().cast<double>();
+            }
             k_index += small_variables[k]->size();
         }
         i_index += small_variables[i]->size();
@@ -216,13 +330,17 @@ Eigen::MatrixXd StateHelper::get_marginal_covariance(State *state, const std::ve
 Eigen::MatrixXd StateHelper::get_full_covariance(State *state) {
 
     // Size of the covariance is the active
-    int cov_size = (int)state->_Cov.rows();
+    int cov_size = (int)state->Cov().rows();
 
     // Construct our return covariance
     Eigen::MatrixXd full_cov = Eigen::MatrixXd::Zero(cov_size, cov_size);
 
     // Copy in the active state elements
-    full_cov.block(0,0,state->_Cov.rows(),state->_Cov.rows()) = state->_Cov;
+    if (state->_options.use_sqrt_covariance) {
+        full_cov = (state->Cov().transpose() * state->Cov()).cast<double>();
+    } else {
+        full_cov.block(0,0,state->Cov().rows(),state->Cov().rows()) = state->Cov().cast<double>().selfadjointView<Eigen::Upper>();
+    }
 
     // Return the covariance
     return full_cov;
@@ -233,12 +351,23 @@ Eigen::MatrixXd StateHelper::get_full_covariance(State *state) {
 
 
 void StateHelper::marginalize(State *state, Type *marg) {
+    StateHelper::marginalize(state, std::vector<Type*>{marg});
+}
 
-    // Check if the current state has the element we want to marginalize
-    if (std::find(state->_variables.begin(), state->_variables.end(), marg) == state->_variables.end()) {
-        printf(RED "StateHelper::marginalize() - Called on variable that is not in the state\n" RESET);
-        printf(RED "StateHelper::marginalize() - Marginalization, does NOT work on sub-variables yet...\n" RESET);
-        std::exit(EXIT_FAILURE);
+
+void StateHelper::marginalize(State *state, const std::vector<Type*> &marg) {
+
+    // Check if the current state has the elements we want to marginalize
+    for (Type *var : marg) {
+        if (std::find(state->_variables.begin(), state->_variables.end(), var) == state->_variables.end()) {
+            printf(RED "StateHelper::marginalize() - Called on variable that is not in the state\n" RESET);
+            printf(RED "StateHelper::marginalize() - Marginalization, does NOT work on sub-variables yet...\n" RESET);
+            std::exit(EXIT_FAILURE);
+        }
+        if (std::count(marg.begin(), marg.end(), var) != 1) {
+            printf(RED "StateHelper::marginalize() - Called with the same variable multiple times\n" RESET);
+            std::exit(EXIT_FAILURE);
+        }
     }
 
     //Generic covariance has this form for x_1, x_m, x_2. If we want to remove x_m:
@@ -253,47 +382,71 @@ void StateHelper::marginalize(State *state, Type *marg) {
     //  P_(x_2,x_1) P(x_2,x_2)
     //
     // i.e. x_1 goes from 0 to marg_id, x_2 goes from marg_id+marg_size to Cov.rows() in the original covariance
-
-    int marg_size = marg->size();
-    int marg_id = marg->id();
-    int x2_size = (int)state->_Cov.rows() - marg_id - marg_size;
-
-    Eigen::MatrixXd Cov_new(state->_Cov.rows() - marg_size, state->_Cov.rows() - marg_size);
-
-    //P_(x_1,x_1)
-    Cov_new.block(0, 0, marg_id, marg_id) = state->_Cov.block(0, 0, marg_id, marg_id);
-
-    //P_(x_1,x_2)
-    Cov_new.block(0, marg_id, marg_id, x2_size) = state->_Cov.block(0, marg_id + marg_size, marg_id, x2_size);
-
-    //P_(x_2,x_1)
-    Cov_new.block(marg_id, 0, x2_size, marg_id) = Cov_new.block(0, marg_id, marg_id, x2_size).transpose();
-
-    //P(x_2,x_2)
-    Cov_new.block(marg_id, marg_id, x2_size, x2_size) = state->_Cov.block(marg_id + marg_size, marg_id + marg_size, x2_size, x2_size);
-
-
-    // Now set new covariance
-    state->_Cov = Cov_new;
-    //state->Cov() = 0.5*(Cov_new+Cov_new.transpose());
-    assert(state->_Cov.rows() == Cov_new.rows());
+    // For multiple variables we just remove all their rows and columns at the same time
+    // This is done in place in our covariance storage, so no new covariance needs to be allocated
+    std::vector<std::pair<int,int>> marg_blocks;
+    for (Type *var : marg) {
+        marg_blocks.emplace_back(var->id(), var->size());
+    }
+    std::sort(marg_blocks.begin(), marg_blocks.end());
+    if (state->_options.use_sqrt_covariance) {
+        // For the square-root covariance we just need to remove the columns of the factor since P = U^T*U
+        // The remaining columns are moved to the left, and then we re-triangularize with Householder reflections
+        // Each column only has non-zeros down to its original location, so we only need to reflect those rows
+        CovMatrix &U = state->_Cov_arena;
+        int old_size = state->_Cov_size;
+        std::vector<int> kept_id;
+        size_t it_block = 0;
+        for (int c = 0; c < old_size; c++) {
+            while (it_block < marg_blocks.size() && c >= marg_blocks.at(it_block).first + marg_blocks.at(it_block).second)
+                it_block++;
+            if (it_block < marg_blocks.size() && c >= marg_blocks.at(it_block).first)
+                continue;
+            if ((int)kept_id.size() != c)
+                U.col(kept_id.size()).head(old_size) = U.col(c).head(old_size);
+            kept_id.push_back(c);
+        }
+        int new_size = (int)kept_id.size();
+        std::vector<CovScalar> workspace(new_size);
+        for (int c = 0; c < new_size; c++) {
+            int num_rows = kept_id.at(c) - c;
+            if (num_rows < 1)
+                continue;
+            CovScalar tau, beta;
+            U.col(c).segment(c, num_rows+1).makeHouseholderInPlace(tau, beta);
+            U.block(c, c+1, num_rows+1, new_size-c-1).applyHouseholderOnTheLeft(U.col(c).segment(c+1, num_rows), tau, workspace.data());
+            U(c,c) = beta;
+            U.col(c).segment(c+1, num_rows).setZero();
+        }
+        state->_Cov_size = new_size;
+    } else {
+        state->cov_remove(marg_blocks);
+    }
 
     // Now we keep the remaining variables and update their ordering
+    // Each variable needs to be "moved forward" by the size of all marginalized variables before it
     // Note: DOES NOT SUPPORT MARGINALIZING SUBVARIABLES YET!!!!!!!
     std::vector<Type *> remaining_variables;
     for (size_t i = 0; i < state->_variables.size(); i++) {
         // Only keep non-marginal states
-        if (state->_variables.at(i) != marg) {
-            if (state->_variables.at(i)->id() > marg_id) {
-                // If the variable is "beyond" the marginal one in ordering, need to "move it forward"
-                state->_variables.at(i)->set_local_id(state->_variables.at(i)->id() - marg_size);
-            }
-            remaining_variables.push_back(state->_variables.at(i));
+        Type *var = state->_variables.at(i);
+        if (std::find(marg.begin(), marg.end(), var) != marg.end())
+            continue;
+        int shift = 0;
+        for (const auto &block : marg_blocks) {
+            if (block.first < var->id())
+                shift += block.second;
+        }
+        if (shift > 0) {
+            var->set_local_id(var->id() - shift);
         }
+        remaining_variables.push_back(var);
     }
 
-    // Delete the old state variable to free up its memory
-    delete marg;
+    // Delete the old state variables to free up their memory
+    for (Type *var : marg) {
+        delete var;
+    }
 
     // Now set variables as the remaining ones
     state->_variables = remaining_variables;
@@ -305,11 +458,11 @@ Type* StateHelper::clone(State *state, Type *variable_to_clone) {
 
     //Get total size of new cloned variables, and the old covariance size
     int total_size = variable_to_clone->size();
-    int old_size = (int)state->_Cov.rows();
-    int new_loc = (int)state->_Cov.rows();
+    int old_size = (int)state->Cov().rows();
+    int new_loc = (int)state->Cov().rows();
 
     // Resize both our covariance to the new size
-    state->_Cov.conservativeResizeLike(Eigen::MatrixXd::Zero(old_size + total_size, old_size + total_size));
+    state->cov_grow(total_size);
 
     // What is the new state, and variable we inserted
     const std::vector<Type*> new_variables = state->_variables;
@@ -327,9 +480,13 @@ Type* StateHelper::clone(State *state, Type *variable_to_clone) {
         int old_loc = type_check->id();
 
         // Copy the covariance elements
-        state->_Cov.block(new_loc, new_loc, total_size, total_size) = state->_Cov.block(old_loc, old_loc, total_size, total_size);
-        state->_Cov.block(0, new_loc, old_size, total_size) = state->_Cov.block(0, old_loc, old_size, total_size);
-        state->_Cov.block(new_loc, 0, total_size, old_size) = state->_Cov.block(old_loc, 0, total_size, old_size);
+        // For the square-root covariance the clone is just a copy of the columns of the factor (the new rows are zero)
+        if (state->_options.use_sqrt_covariance) {
+            state->Cov().block(0, new_loc, old_size, total_size) = state->Cov().block(0, old_loc, old_size, total_size);
+        } else {
+            state->Cov().block(new_loc, new_loc, total_size, total_size) = state->Cov().block(old_loc, old_loc, total_size, total_size);
+            state->cov_block(0, old_loc, old_size, total_size, state->Cov().block(0, new_loc, old_size, total_size));
+        }
 
         // Create clone from the type being cloned
         new_clone = type_check->clone();
@@ -481,7 +638,6 @@ void StateHelper::initialize_invertible(State *state, Type *new_variable, const
     assert(res.rows() == R.rows());
     assert(H_L.rows() == res.rows());
     assert(H_L.rows() == H_R.rows());
-    Eigen::MatrixXd M_a = Eigen::MatrixXd::Zero(state->_Cov.rows(), res.rows());
 
     // Get the location in small jacobian for each measuring variable
     int current_it = 0;
@@ -490,26 +646,53 @@ void StateHelper::initialize_invertible(State *state, Type *new_variable, const
         H_id.push_back(current_it);
         current_it += meas_var->size();
     }
+    assert(H_R.cols() == current_it);
+
+    // If we are storing the square-root covariance, then we can directly append the factor of the new variable
+    // Since x_new = H_L^{-1}*(res - H_R*x_R - n) the new columns are -U(:,R)*H_R^T*H_L^{-T}
+    // The new diagonal block is the factor of H_L^{-1}*R*H_L^{-T} which is the noise that only this variable sees
+    if (state->_options.use_sqrt_covariance) {
+        assert(H_L.rows()==H_L.cols());
+        assert(H_L.rows() == new_variable->size());
+        int row_max = 0;
+        for (Type *meas_var: H_order) {
+            row_max = std::max(row_max, meas_var->id() + meas_var->size());
+        }
+        CovMatrix U_cols(row_max, current_it);
+        for (size_t i = 0; i < H_order.size(); i++) {
+            U_cols.middleCols(H_id[i], H_order[i]->size()) = state->Cov().block(0, H_order[i]->id(), row_max, H_order[i]->size());
+        }
+        Eigen::MatrixXd H_Linv = H_L.inverse();
+        Eigen::MatrixXd P_noise = H_Linv * R * H_Linv.transpose();
+        size_t oldSize = state->Cov().rows();
+        state->cov_grow(new_variable->size());
+        state->Cov().block(0, oldSize, row_max, new_variable->size()).noalias() = -U_cols * (H_Linv * H_R).transpose().cast<CovScalar>();
+        state->Cov().block(oldSize, oldSize, new_variable->size(), new_variable->size()) = P_noise.llt().matrixU().toDenseMatrix().cast<CovScalar>();
+        new_variable->update(H_Linv * res);
+        new_variable->set_local_id(oldSize);
+        state->_variables.push_back(new_variable);
+        return;
+    }
 
     //==========================================================
     //==========================================================
-    // For each active variable find its M = P*H^T
-    for (Type *var: state->_variables) {
-        // Sum up effect of each subjacobian= K_i= \sum_m (P_im Hm^T)
-        Eigen::MatrixXd M_i = Eigen::MatrixXd::Zero(var->size(), res.rows());
-        for (size_t i = 0; i < H_order.size(); i++) {
-            Type *meas_var = H_order[i];
-            M_i += state->_Cov.block(var->id(), meas_var->id(), var->size(), meas_var->size()) *
-                   H_R.block(0, H_id[i], H_R.rows(), meas_var->size()).transpose();
-        }
-        M_a.block(var->id(), 0, var->size(), res.rows()) = M_i;
+    // Gather the touched covariance columns and find M = P*H^T as a single GEMM
+    CovMatrix P_cols(state->Cov().rows(), current_it);
+    for (size_t i = 0; i < H_order.size(); i++) {
+        state->cov_block(0, H_order[i]->id(), state->Cov().rows(), H_order[i]->size(), P_cols.middleCols(H_id[i], H_order[i]->size()));
     }
+    CovMatrix M_a(state->Cov().rows(), res.rows());
+    M_a.noalias() = P_cols * H_R.transpose().cast<CovScalar>();
 
 
     //==========================================================
     //==========================================================
     // Get covariance of this small jacobian
-    Eigen::MatrixXd P_small = StateHelper::get_marginal_covariance(state, H_order);
+    Eigen::MatrixXd P_small(current_it, current_it);
+    for (size_t i = 0; i < H_order.size(); i++) {
+        P_small.middleRows(H_id[i], H_order[i]->size()) = P_cols.middleRows(H_order[i]->id(), H_order[i]->size()).cast<double>();
+    }
+    P_cols.resize(0, 0);
 
     // M = H_R*Cov*H_R' + R
     Eigen::MatrixXd M(H_R.rows(), H_R.rows());
@@ -523,11 +706,10 @@ void StateHelper::initialize_invertible(State *state, Type *new_variable, const
     Eigen::MatrixXd P_LL = H_Linv * M.selfadjointView<Eigen::Upper>() * H_Linv.transpose();
 
     // Augment the covariance matrix
-    size_t oldSize = state->_Cov.rows();
-    state->_Cov.conservativeResizeLike(Eigen::MatrixXd::Zero(oldSize + new_variable->size(), oldSize + new_variable->size()));
-    state->_Cov.block(0, oldSize, oldSize, new_variable->size()).noalias() = -M_a * H_Linv.transpose();
-    state->_Cov.block(oldSize, 0, new_variable->size(), oldSize) = state->_Cov.block(0, oldSize, oldSize, new_variable->size()).transpose();
-    state->_Cov.block(oldSize, oldSize, new_variable->size(), new_variable->size()) = P_LL;
+    size_t oldSize = state->Cov().rows();
+    state->cov_grow(new_variable->size());
+    state->Cov().block(0, oldSize, oldSize, new_variable->size()).noalias() = -M_a * H_Linv.transpose().cast<CovScalar>();
+    state->Cov().block(oldSize, oldSize, new_variable->size(), new_variable->size()) = P_LL.cast<CovScalar>();
 
     // Update the variable that will be initialized (invertible systems can only update the new variable).
     // However this update should be almost zero if we already used a conditional Gauss-Newton to solve for the initial estimate
@@ -570,11 +752,167 @@ void StateHelper::augment_clone(State *state, Eigen::Matrix<double, 3, 1> last_w
         dnc_dt.block(0, 0, 3, 1) = last_w;
         dnc_dt.block(3, 0, 3, 1) = state->_imu->vel();
         // Augment covariance with time offset Jacobian
-        state->_Cov.block(0, pose->id(), state->_Cov.rows(), 6) +=
-                state->_Cov.block(0, state->_calib_dt_CAMtoIMU->id(), state->_Cov.rows(), 1) * dnc_dt.transpose();
-        state->_Cov.block(pose->id(), 0, 6, state->_Cov.rows()) +=
-                dnc_dt * state->_Cov.block(state->_calib_dt_CAMtoIMU->id(), 0, 1, state->_Cov.rows());
+        // For the square-root covariance only the columns of the factor need to change
+        // Otherwise we update the columns and then the diagonal block of the clone (we only keep the upper triangle)
+        if (state->_options.use_sqrt_covariance) {
+            state->Cov().block(0, pose->id(), state->Cov().rows(), 6) +=
+                    state->Cov().block(0, state->_calib_dt_CAMtoIMU->id(), state->Cov().rows(), 1) * dnc_dt.transpose().cast<CovScalar>();
+        } else {
+            CovMatrix Cov_dt(state->Cov().rows(), 1);
+            state->cov_block(0, state->_calib_dt_CAMtoIMU->id(), state->Cov().rows(), 1, Cov_dt);
+            state->Cov().block(0, pose->id(), state->Cov().rows(), 6) += Cov_dt * dnc_dt.transpose().cast<CovScalar>();
+            state->Cov().block(pose->id(), pose->id(), 6, 6) +=
+                    dnc_dt.cast<CovScalar>() * state->Cov().block(state->_calib_dt_CAMtoIMU->id(), pose->id(), 1, 6);
+        }
     }
 
 }
 
+
+
+
+void StateHelper::EKFPropagation_sqrt(State *state, const std::vector<Type*> &order_NEW, const std::vector<Type*> &order_OLD,
+                                      const std::vector<int> &Phi_id, const Eigen::MatrixXd &Phi, const Eigen::MatrixXd &Q) {
+
+    // Our factor is P = U^T*U, thus we have P' = (U*A^T)^T*(U*A^T) + W^T*W where A is the state transition
+    // The new columns are U(:,new) = U(:,old)*Phi^T, which are only non-zero up to the last old or new variable
+    Eigen::Block<CovMatrix> U = state->Cov();
+    int total_size = U.rows();
+    int start_id = order_NEW.at(0)->id();
+    int phi_size = Phi.rows();
+    int row_max = start_id + phi_size;
+    for (Type *var : order_OLD) {
+        row_max = std::max(row_max, var->id() + var->size());
+    }
+    CovMatrix U_new = CovMatrix::Zero(row_max, phi_size);
+    for (size_t i=0; i<order_OLD.size(); i++) {
+        Type *var = order_OLD.at(i);
+        U_new.noalias() += U.block(0, var->id(), row_max, var->size()) * Phi.block(0, Phi_id[i], phi_size, var->size()).transpose().cast<CovScalar>();
+    }
+    U.middleCols(start_id, phi_size).setZero();
+    U.block(0, start_id, row_max, phi_size) = U_new;
+
+    // Our noise rows need W^T*W = Q, we use LDLT since the noise might only be semi-definite (Q = P^T*L*D*L^T*P)
+    CovMatrix W = CovMatrix::Zero(0, total_size);
+    Eigen::MatrixXd Q_full = Q.selfadjointView<Eigen::Upper>();
+    if (!Q_full.isZero(0)) {
+        Eigen::LDLT<Eigen::MatrixXd> ldlt(Q_full);
+        Eigen::MatrixXd Pt = ldlt.transpositionsP().transpose() * Eigen::MatrixXd::Identity(phi_size, phi_size);
+        Eigen::VectorXd sqrtD = ldlt.vectorD().cwiseMax(0.0).cwiseSqrt();
+        W = CovMatrix::Zero(phi_size, total_size);
+        W.middleCols(start_id, phi_size) = (sqrtD.asDiagonal() * Eigen::MatrixXd(ldlt.matrixU()) * Pt.transpose()).cast<CovScalar>();
+    }
+
+    // Now re-triangularize starting from the first column we have changed
+    // Each column has non-zeros below the diagonal down to row_max, along with all the noise rows
+    int num_w = W.rows();
+    Eigen::Matrix<CovScalar,Eigen::Dynamic,1> v, ess;
+    Eigen::Matrix<CovScalar,1,Eigen::Dynamic> w;
+    for (int j = start_id; j < total_size; j++) {
+        int num_u = std::max(0, row_max - j - 1);
+        if (num_u == 0 && num_w == 0)
+            break;
+        v.resize(1 + num_u + num_w);
+        v << U(j,j), U.col(j).segment(j+1, num_u), W.col(j);
+        CovScalar tau, beta;
+        ess.resize(num_u + num_w);
+        v.makeHouseholder(ess, tau, beta);
+        int num_c = total_size - j - 1;
+        if (num_c > 0) {
+            w = U.row(j).tail(num_c);
+            w.noalias() += ess.head(num_u).transpose() * U.block(j+1, j+1, num_u, num_c);
+            w.noalias() += ess.tail(num_w).transpose() * W.rightCols(num_c);
+            w *= tau;
+            U.row(j).tail(num_c) -= w;
+            U.block(j+1, j+1, num_u, num_c).noalias() -= ess.head(num_u) * w;
+            W.rightCols(num_c).noalias() -= ess.tail(num_w) * w;
+        }
+        U(j,j) = beta;
+        U.col(j).segment(j+1, num_u).setZero();
+        W.col(j).setZero();
+    }
+
+}
+
+
+void StateHelper::EKFUpdate_sqrt(State *state, const std::vector<Type *> &H_order, const std::vector<int> &H_id,
+                                 const Eigen::MatrixXd &H, const Eigen::VectorXd &res, const Eigen::MatrixXd &R) {
+
+    // Whiten our measurement so that we have unit noise, and can process each row by itself
+    Eigen::LLT<Eigen::MatrixXd> llt_R(R);
+    Eigen::MatrixXd H_w = llt_R.matrixL().solve(H);
+    Eigen::VectorXd res_w = llt_R.matrixL().solve(res);
+
+    // Only rows up to the last variable in our Jacobian can be non-zero in U*h^T
+    Eigen::Block<CovMatrix> U = state->Cov();
+    int total_size = U.rows();
+    int row_max = 0;
+    for (Type *meas_var: H_order) {
+        row_max = std::max(row_max, meas_var->id() + meas_var->size());
+    }
+
+    // Process each measurement row
+    // Our pre-array is [1 0; U*h^T U] and we zero the first column with Givens rotations from the bottom up
+    // This leaves [sqrt(s) k^T; 0 U'] where s = h*P*h^T+1 is the residual covariance and k = P*h^T/sqrt(s)
+    Eigen::VectorXd dx = Eigen::VectorXd::Zero(total_size);
+    Eigen::Matrix<CovScalar,Eigen::Dynamic,1> f(row_max);
+    Eigen::Matrix<CovScalar,1,Eigen::Dynamic> k(total_size), temp(total_size);
+    for (int r = 0; r < H_w.rows(); r++) {
+
+        // Compute f = U*h^T and the residual with our current correction
+        f.setZero();
+        double res_r = res_w(r);
+        for (size_t i = 0; i < H_order.size(); i++) {
+            f.noalias() += U.block(0, H_order[i]->id(), row_max, H_order[i]->size()) * H_w.block(r, H_id[i], 1, H_order[i]->size()).transpose().cast<CovScalar>();
+            res_r -= H_w.row(r).segment(H_id[i], H_order[i]->size()).dot(dx.segment(H_order[i]->id(), H_order[i]->size()));
+        }
+
+        // Zero each element with a rotation between the first row and that row of the factor
+        CovScalar a = 1.0;
+        k.setZero();
+        for (int i = row_max - 1; i >= 0; i--) {
+            if (f(i) == 0.0)
+                continue;
+            CovScalar rad = std::sqrt(a*a + f(i)*f(i));
+            CovScalar c = a/rad;
+            CovScalar s = f(i)/rad;
+            int num_c = total_size - i;
+            temp.tail(num_c) = k.tail(num_c);
+            k.tail(num_c) = c*temp.tail(num_c) + s*U.row(i).tail(num_c);
+            U.row(i).tail(num_c) = c*U.row(i).tail(num_c) - s*temp.tail(num_c);
+            a = rad;
+        }
+
+        // Our gain is K = P*h^T/s = k/sqrt(s)
+        dx.noalias() += (k.transpose().cast<double>() / (double)a) * res_r;
+
+    }
+
+    // Update all our active states
+    for (size_t i = 0; i < state->_variables.size(); i++) {
+        state->_variables.at(i)->update(dx.block(state->_variables.at(i)->id(), 0, state->_variables.at(i)->size(), 1));
+    }
+
+}
+
+
+void StateHelper::check_covariance(State *state, const std::string &caller) {
+
+    // Nothing to check if we have a square-root factor, the covariance is always positive semi-definite
+    if (state->_options.use_sqrt_covariance)
+        return;
+
+    // We should check if we are not positive semi-definitate (i.e. negative diagionals is not s.p.d)
+    Eigen::VectorXd diags = state->Cov().diagonal().cast<double>();
+    bool found_neg = false;
+    for(int i=0; i<diags.rows(); i++) {
+        if(diags(i) < 0.0 || std::isnan(diags(i))) {
+            printf(RED "StateHelper::%s() - diagonal at %d is %.2f\n" RESET,caller.c_str(),i,diags(i));
+            found_neg = true;
+        }
+    }
+    assert(!found_neg);
+
+}
+
+
@@ -77,6 +77,71 @@ namespace ov_msckf {
         static void EKFPropagation(State *state, const std::vector<Type*> &order_NEW, const std::vector<Type*> &order_OLD,
                                    const Eigen::MatrixXd &Phi, const Eigen::MatrixXd &Q);
 
+        /**
+         * @brief Performs EKF propagation of the state covariance for a fixed size contiguous block.
+         *
+         * This is the same as the above EKFPropagation() for the case where the new and old variables are the same.
+         * Since the size of the block is known at compile time (e.g. 15 for the IMU) all the small products are fixed-size.
+         * Only the cross-covariance between this block and the rest of the state has a dynamic size.
+         *
+         * @param state Pointer to state
+         * @param order Contiguous variables that have evolved according to this state transition
+         * @param Phi State transition matrix (size N by N)
+         * @param Q Additive state propagation noise matrix (size N by N)
+         */
+        template<int N>
+        static void EKFPropagation(State *state, const std::vector<Type*> &order, const Eigen::Matrix<double,N,N> &Phi,
+                                   const Eigen::Matrix<double,N,N> &Q) {
+
+            // The square-root covariance does not have a fixed-size version
+            if (state->_options.use_sqrt_covariance) {
+                StateHelper::EKFPropagation(state, order, order, Phi, Q);
+                return;
+            }
+
+            // We need at least one variable
+            if (order.empty()) {
+                printf(RED "StateHelper::EKFPropagation() - Called with empty variable arrays!\n" RESET);
+                std::exit(EXIT_FAILURE);
+            }
+
+            // Loop through our order and ensure that they are continuous in memory and the correct size
+            int size_order = order.at(0)->size();
+            for(size_t i=0; i<order.size()-1; i++) {
+                if(order.at(i)->id()+order.at(i)->size()!=order.at(i+1)->id()) {
+                    printf(RED "StateHelper::EKFPropagation() - Called with non-contiguous state elements!\n" RESET);
+                    printf(RED "StateHelper::EKFPropagation() - This code only support a state transition which is in the same order as the state\n" RESET);
+                    std::exit(EXIT_FAILURE);
+                }
+                size_order += order.at(i+1)->size();
+            }
+            assert(size_order==N);
+
+            // Cov_PhiT = [ Pxx ] [ Phi' ]'
+            // Phi_Cov_PhiT = Phi*Pxx*Phi' + Q
+            int start_id = order.at(0)->id();
+            int total_size = state->Cov().rows();
+            int end_size = total_size - start_id - N;
+            Eigen::Matrix<CovScalar,Eigen::Dynamic,N> Cov_var(total_size, N);
+            state->cov_block(0, start_id, total_size, N, Cov_var);
+            Eigen::Matrix<CovScalar,Eigen::Dynamic,N> Cov_PhiT(total_size, N);
+            Cov_PhiT.noalias() = Cov_var * Phi.transpose().template cast<CovScalar>();
+            Eigen::Matrix<double,N,N> Phi_Cov_PhiT = Q.template selfadjointView<Eigen::Upper>();
+            Phi_Cov_PhiT.noalias() += Phi * Cov_PhiT.template middleRows<N>(start_id).template cast<double>();
+
+            // We are good to go!
+            // Note that we only need to write the upper triangular portion of our covariance
+            state->Cov().block(0, start_id, start_id, N) = Cov_PhiT.topRows(start_id);
+            state->Cov().block(start_id, start_id + N, N, end_size) = Cov_PhiT.bottomRows(end_size).transpose();
+            state->Cov().template block<N,N>(start_id,start_id) = Phi_Cov_PhiT.template cast<CovScalar>();
+
+            // We should check if we are not positive semi-definitate (i.e. negative diagionals is not s.p.d)
+            if (state->_options.do_diagnostics) {
+                StateHelper::check_covariance(state, "EKFPropagation");
+            }
+
+        }
+
         /**
          * @brief Performs EKF update of the state (see @ref linear-meas page)
          * @param state Pointer to state
@@ -88,6 +153,28 @@ namespace ov_msckf {
         static void EKFUpdate(State *state, const std::vector<Type *> &H_order, const Eigen::MatrixXd &H,
                               const Eigen::VectorXd &res, const Eigen::MatrixXd &R);
 
+        /**
+         * @brief Performs EKF update of the state given the measurement in information form.
+         *
+         * Instead of a stacked Jacobian we are given the information Lambda = H^T*R^{-1}*H and the vector b = H^T*R^{-1}*res.
+         * Using the matrix inversion lemma, with P_ss = L*L^T the covariance of the involved variables, we have that:
+         * \f{align*}{
+         * \mathbf{T} &= \mathbf{I} + \mathbf{L}^\top\mathbf{\Lambda}\mathbf{L} \\
+         * \mathbf{B} &= \mathbf{P}(:,s)\mathbf{L}^{-\top} \\
+         * \delta\mathbf{x} &= \mathbf{B}\mathbf{T}^{-1}\mathbf{L}^\top\mathbf{b} \\
+         * \mathbf{P}^\oplus &= \mathbf{P} - \mathbf{B}(\mathbf{I}-\mathbf{T}^{-1})\mathbf{B}^\top
+         * \f}
+         * This only needs factorizations of the size of the involved state, and thus is cheaper than EKFUpdate() when we have more
+         * measurements then involved state variables. Note that this is not supported for the square-root covariance.
+         *
+         * @param state Pointer to state
+         * @param H_order Variable ordering used in the information matrix
+         * @param Lambda Information of the measurement H^T*R^{-1}*H (only the upper triangular is used)
+         * @param b Information vector of the measurement H^T*R^{-1}*res
+         */
+        static void EKFUpdateInformation(State *state, const std::vector<Type *> &H_order, const Eigen::MatrixXd &Lambda,
+                                         const Eigen::VectorXd &b);
+
         /**
         * @brief For a given set of variables, this will this will calculate a smaller covariance.
         *
@@ -128,6 +215,18 @@ namespace ov_msckf {
          */
         static void marginalize(State *state, Type *marg);
 
+        /**
+         * @brief Marginalizes a set of variables, properly modifying the ordering/covariances in the state
+         *
+         * This is the same as calling marginalize() on each variable, but the covariance is only compacted once.
+         * The ids of the remaining variables are also updated in a single pass.
+         * This should be used when we are removing many variables at the same time (e.g. a lot of lost SLAM features).
+         *
+         * @param state Pointer to state
+         * @param marg Pointers to variables to marginalize
+         */
+        static void marginalize(State *state, const std::vector<Type*> &marg);
+
 
         /**
          * @brief Clones "variable to clone" and places it at end of covariance
@@ -230,20 +329,54 @@ namespace ov_msckf {
         static void marginalize_slam(State* state) {
             // Remove SLAM features that have their marginalization flag set
             // We also check that we do not remove any aruoctag landmarks
+            // All features are marginalized together so we only compact the covariance once
+            std::vector<Type*> marg;
             auto it0 = state->_features_SLAM.begin();
             while(it0 != state->_features_SLAM.end()) {
                 if((*it0).second->should_marg && (int)(*it0).first > state->_options.max_aruco_features) {
-                    StateHelper::marginalize(state, (*it0).second);
+                    marg.push_back((*it0).second);
                     it0 = state->_features_SLAM.erase(it0);
                 } else {
                     it0++;
                 }
             }
+            if(!marg.empty()) {
+                StateHelper::marginalize(state, marg);
+            }
         }
 
 
     private:
 
+        /**
+         * @brief Square-root version of EKFPropagation().
+         *
+         * The columns of the factor for the new variables are replaced by U*Phi^T, and the noise is appended as extra rows.
+         * We then re-triangularize with Householder reflections starting from the first propagated column.
+         * Only the rows that can be non-zero below the diagonal are touched, thus for the IMU at the start of the state this is cheap.
+         */
+        static void EKFPropagation_sqrt(State *state, const std::vector<Type*> &order_NEW, const std::vector<Type*> &order_OLD,
+                                        const std::vector<int> &Phi_id, const Eigen::MatrixXd &Phi, const Eigen::MatrixXd &Q);
+
+        /**
+         * @brief Square-root version of EKFUpdate().
+         *
+         * The measurement is whitened and then processed one row at a time.
+         * For each row we use Givens rotations to zero U*h^T in the pre-array [1 0; U*h^T U], which gives the updated factor
+         * and the Kalman gain at the same time. The covariance thus can never lose positive semi-definiteness.
+         */
+        static void EKFUpdate_sqrt(State *state, const std::vector<Type *> &H_order, const std::vector<int> &H_id,
+                                   const Eigen::MatrixXd &H, const Eigen::VectorXd &res, const Eigen::MatrixXd &R);
+
+        /**
+         * @brief Checks that the covariance is still healthy (no negative or NaN diagonal entries).
+         *
+         * This is only called if StateOptions::do_diagnostics is set since it needs to read the whole diagonal.
+         * @param state Pointer to state
+         * @param caller Name of the function that called us (used for printing)
+         */
+        static void check_covariance(State *state, const std::string &caller);
+
         /**
          * All function in this class should be static.
          * Thus an instance of this class cannot be created.
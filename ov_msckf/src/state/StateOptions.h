@@ -42,6 +42,15 @@ namespace ov_msckf {
         /// Bool to determine if we should use Rk4 imu integration
         bool use_rk4_integration = true;
 
+        /// Continuous preintegration model to propagate with (0 = per reading, 1 = CpiV1, 2 = CpiV2), the rk4 setting is not used by these
+        int prop_cpi_model = 0;
+
+        /// Bool to determine if we should store an upper-triangular square-root factor of the covariance instead of the covariance
+        bool use_sqrt_covariance = false;
+
+        /// Bool to determine if we should run covariance health checks after each propagation and update (slow)
+        bool do_diagnostics = false;
+
         /// Bool to determine whether or not to calibrate imu-to-camera pose
         bool do_calib_camera_pose = false;
 
@@ -83,6 +92,9 @@ namespace ov_msckf {
             printf("\t- use_fej: %d\n", do_fej);
             printf("\t- use_imuavg: %d\n", imu_avg);
             printf("\t- use_rk4int: %d\n", use_rk4_integration);
+            printf("\t- prop_cpi_model: %d\n", prop_cpi_model);
+            printf("\t- use_sqrt_cov: %d\n", use_sqrt_covariance);
+            printf("\t- use_diagnostics: %d\n", do_diagnostics);
             printf("\t- calib_cam_extrinsics: %d\n", do_calib_camera_pose);
             printf("\t- calib_cam_intrinsics: %d\n", do_calib_camera_intrinsics);
             printf("\t- calib_cam_timeoffset: %d\n", do_calib_camera_timeoffset);
@@ -309,14 +309,14 @@ void UpdaterHelper::get_feature_jacobian_full(State* state, UpdaterHelperFeature
 
     // Total number of measurements for this feature
     int total_meas = 0;
-    for (auto const& pair : feature.timestamps) {
+    for (auto const& pair : *feature.timestamps) {
         total_meas += (int)pair.second.size();
     }
 
     // Compute the size of the states involved with this feature
     int total_hx = 0;
     std::unordered_map<Type*,size_t> map_hx;
-    for (auto const& pair : feature.timestamps) {
+    for (auto const& pair : *feature.timestamps) {
 
         // Our extrinsics and intrinsics
         PoseJPL *calibration = state->_calib_IMUtoCAM.at(pair.first);
@@ -337,10 +337,10 @@ void UpdaterHelper::get_feature_jacobian_full(State* state, UpdaterHelperFeature
         }
 
         // Loop through all measurements for this specific camera
-        for (size_t m = 0; m < feature.timestamps[pair.first].size(); m++) {
+        for (size_t m = 0; m < feature.timestamps->at(pair.first).size(); m++) {
 
             // Add this clone if it is not added already
-            PoseJPL *clone_Ci = state->_clones_IMU.at(feature.timestamps[pair.first].at(m));
+            PoseJPL *clone_Ci = state->_clones_IMU.at(feature.timestamps->at(pair.first).at(m));
             if(map_hx.find(clone_Ci) == map_hx.end()) {
                 map_hx.insert({clone_Ci,total_hx});
                 x_order.push_back(clone_Ci);
@@ -427,7 +427,7 @@ void UpdaterHelper::get_feature_jacobian_full(State* state, UpdaterHelperFeature
     }
 
     // Loop through each camera for this feature
-    for (auto const& pair : feature.timestamps) {
+    for (auto const& pair : *feature.timestamps) {
 
         // Our calibration between the IMU and CAMi frames
         Vec* distortion = state->_cam_intrinsics.at(pair.first);
@@ -437,13 +437,13 @@ void UpdaterHelper::get_feature_jacobian_full(State* state, UpdaterHelperFeature
         Eigen::Matrix<double,8,1> cam_d = distortion->value();
 
         // Loop through all measurements for this specific camera
-        for (size_t m = 0; m < feature.timestamps[pair.first].size(); m++) {
+        for (size_t m = 0; m < feature.timestamps->at(pair.first).size(); m++) {
 
             //=========================================================================
             //=========================================================================
 
             // Get current IMU clone state
-            PoseJPL* clone_Ii = state->_clones_IMU.at(feature.timestamps[pair.first].at(m));
+            PoseJPL* clone_Ii = state->_clones_IMU.at(feature.timestamps->at(pair.first).at(m));
             Eigen::Matrix<double,3,3> R_GtoIi = clone_Ii->Rot();
             Eigen::Matrix<double,3,1> p_IiinG = clone_Ii->pos();
 
@@ -491,7 +491,7 @@ void UpdaterHelper::get_feature_jacobian_full(State* state, UpdaterHelperFeature
 
             // Our residual
             Eigen::Matrix<double,2,1> uv_m;
-            uv_m << (double)feature.uvs[pair.first].at(m)(0), (double)feature.uvs[pair.first].at(m)(1);
+            uv_m << (double)feature.uvs->at(pair.first).at(m)(0), (double)feature.uvs->at(pair.first).at(m)(1);
             res.block(2*c,0,2,1) = uv_m - uv_dist;
 
 
@@ -585,22 +585,12 @@ void UpdaterHelper::get_feature_jacobian_full(State* state, UpdaterHelperFeature
 void UpdaterHelper::nullspace_project_inplace(Eigen::MatrixXd &H_f, Eigen::MatrixXd &H_x, Eigen::VectorXd &res) {
 
     // Apply the left nullspace of H_f to all variables
-    // Based on "Matrix Computations 4th Edition by Golub and Van Loan"
-    // See page 252, Algorithm 5.2.4 for how these two loops work
-    // They use "matlab" index notation, thus we need to subtract 1 from all index
-    Eigen::JacobiRotation<double> tempHo_GR;
-    for (int n = 0; n < H_f.cols(); ++n) {
-        for (int m = (int) H_f.rows() - 1; m > n; m--) {
-            // Givens matrix G
-            tempHo_GR.makeGivens(H_f(m - 1, n), H_f(m, n));
-            // Multiply G to the corresponding lines (m-1,m) in each matrix
-            // Note: we only apply G to the nonzero cols [n:Ho.cols()-n-1], while
-            //       it is equivalent to applying G to the entire cols [0:Ho.cols()-1].
-            (H_f.block(m - 1, n, 2, H_f.cols() - n)).applyOnTheLeft(0, 1, tempHo_GR.adjoint());
-            (H_x.block(m - 1, 0, 2, H_x.cols())).applyOnTheLeft(0, 1, tempHo_GR.adjoint());
-            (res.block(m - 1, 0, 2, 1)).applyOnTheLeft(0, 1, tempHo_GR.adjoint());
-        }
-    }
+    // We compute the Householder QR of the tall H_f = Q*R, whose last rows of Q^T span the left nullspace of H_f
+    // Q^T is then applied to H_x with the blocked Householder application, instead of two rows at a time with Givens
+    // Based on "Matrix Computations 4th Edition by Golub and Van Loan", see section 5.2.2
+    Eigen::HouseholderQR<Eigen::Ref<Eigen::MatrixXd>> qr(H_f);
+    H_x.applyOnTheLeft(qr.householderQ().adjoint());
+    res.applyOnTheLeft(qr.householderQ().adjoint());
 
     // The H_f jacobian max rank is 3 if it is a 3d position, thus size of the left nullspace is Hf.rows()-3
     // NOTE: need to eigen3 eval here since this experiences aliasing!
@@ -622,31 +612,51 @@ void UpdaterHelper::measurement_compress_inplace(Eigen::MatrixXd &H_x, Eigen::Ve
     if(H_x.rows() <= H_x.cols())
         return;
 
-    // Do measurement compression through givens rotations
-    // Based on "Matrix Computations 4th Edition by Golub and Van Loan"
-    // See page 252, Algorithm 5.2.4 for how these two loops work
-    // They use "matlab" index notation, thus we need to subtract 1 from all index
-    Eigen::JacobiRotation<double> tempHo_GR;
-    for (int n=0; n<H_x.cols(); n++) {
-        for (int m=(int)H_x.rows()-1; m>n; m--) {
-            // Givens matrix G
-            tempHo_GR.makeGivens(H_x(m-1,n), H_x(m,n));
-            // Multiply G to the corresponding lines (m-1,m) in each matrix
-            // Note: we only apply G to the nonzero cols [n:Ho.cols()-n-1], while
-            //       it is equivalent to applying G to the entire cols [0:Ho.cols()-1].
-            (H_x.block(m-1,n,2,H_x.cols()-n)).applyOnTheLeft(0,1,tempHo_GR.adjoint());
-            (res.block(m-1,0,2,1)).applyOnTheLeft(0,1,tempHo_GR.adjoint());
-        }
+    // Do measurement compression on the augmented system [H_x res]
+    Eigen::MatrixXd Hres(H_x.rows(), H_x.cols()+1);
+    Hres << H_x, res;
+    compress_augmented(Hres, H_x, res);
+
+}
+
+
+
+void UpdaterHelper::measurement_compress(const CovMatrix &H_x_big, Eigen::VectorXd &res, Eigen::MatrixXd &H_x) {
+
+
+    // Return if H_x is a fat matrix (there is no need to compress in this case)
+    if(H_x_big.rows() <= H_x_big.cols()) {
+        H_x = H_x_big.cast<double>();
+        return;
     }
 
+    // Do measurement compression on the augmented system [H_x res]
+    // This is the only copy of the stacked jacobian in double precision, which the QR needs to accumulate into
+    Eigen::MatrixXd Hres(H_x_big.rows(), H_x_big.cols()+1);
+    Hres << H_x_big.cast<double>(), res;
+    compress_augmented(Hres, H_x, res);
+
+}
+
+
+
+void UpdaterHelper::compress_augmented(Eigen::MatrixXd &Hres, Eigen::MatrixXd &H_x, Eigen::VectorXd &res) {
+
+    // Do measurement compression through a Householder QR of the augmented system [H_x res]
+    // The upper triangular R factor has Q^T*H_x in its first columns and Q^T*res in its last column
+    // Eigen will factor this in panels and apply the reflectors as matrix products, which is far more cache friendly than Givens
+    // Based on "Matrix Computations 4th Edition by Golub and Van Loan", see section 5.2.2
+    Eigen::HouseholderQR<Eigen::Ref<Eigen::MatrixXd>> qr(Hres);
+
     // If H is a fat matrix, then use the rows
     // Else it should be same size as our state
-    int r = std::min(H_x.rows(),H_x.cols());
+    int cols = (int)Hres.cols()-1;
+    int r = std::min((int)Hres.rows(),cols);
 
     // Construct the smaller jacobian and residual after measurement compression
-    assert(r<=H_x.rows());
-    H_x.conservativeResize(r, H_x.cols());
-    res.conservativeResize(r, res.cols());
+    assert(r<=Hres.rows());
+    H_x = Hres.topLeftCorner(r, cols).triangularView<Eigen::Upper>();
+    res = Hres.block(0, cols, r, 1);
 
 }
 
@@ -58,14 +58,14 @@ namespace ov_msckf {
             /// Unique ID of this feature
             size_t featid;
 
-            /// UV coordinates that this feature has been seen from (mapped by camera ID)
-            std::unordered_map<size_t, std::vector<Eigen::VectorXf>> uvs;
+            /// UV coordinates that this feature has been seen from (points to the measurements of the Feature, mapped by camera ID)
+            const std::unordered_map<size_t, std::vector<Eigen::Vector2f>> *uvs = nullptr;
 
-            // UV normalized coordinates that this feature has been seen from (mapped by camera ID)
-            std::unordered_map<size_t, std::vector<Eigen::VectorXf>> uvs_norm;
+            /// UV normalized coordinates that this feature has been seen from (points to the measurements of the Feature, mapped by camera ID)
+            const std::unordered_map<size_t, std::vector<Eigen::Vector2f>> *uvs_norm = nullptr;
 
-            /// Timestamps of each UV measurement (mapped by camera ID)
-            std::unordered_map<size_t, std::vector<double>> timestamps;
+            /// Timestamps of each UV measurement (points to the measurements of the Feature, mapped by camera ID)
+            const std::unordered_map<size_t, std::vector<double>> *timestamps = nullptr;
 
             /// What representation our feature is in
             LandmarkRepresentation::Representation feat_representation;
@@ -155,6 +155,31 @@ namespace ov_msckf {
         static void measurement_compress_inplace(Eigen::MatrixXd &H_x, Eigen::VectorXd &res);
 
 
+        /**
+         * @brief This will perform measurement compression of a jacobian stacked in the precision of our covariance
+         *
+         * Only the QR is accumulated in double precision, so the large stacked jacobian can be kept in single precision.
+         * Please see the @ref update-compress for details on how this works.
+         *
+         * @param H_x_big Stacked state jacobian
+         * @param res Measurement residual (will be compressed in place)
+         * @param H_x Compressed state jacobian
+         */
+        static void measurement_compress(const CovMatrix &H_x_big, Eigen::VectorXd &res, Eigen::MatrixXd &H_x);
+
+
+    protected:
+
+
+        /**
+         * @brief Compresses the augmented system [H_x res] through a Householder QR
+         * @param Hres Augmented system, will be overwritten by its R factor
+         * @param H_x Compressed state jacobian
+         * @param res Compressed measurement residual
+         */
+        static void compress_augmented(Eigen::MatrixXd &Hres, Eigen::MatrixXd &H_x, Eigen::VectorXd &res);
+
+
 
     };
 
@@ -26,6 +26,26 @@ using namespace ov_core;
 using namespace ov_msckf;
 
 
+namespace {
+
+    /// Linear system of a single feature after nullspace projection
+    struct FeatureLinsys {
+
+        /// Jacobian in respect to the state
+        Eigen::MatrixXd H_x;
+
+        /// Residual of this feature
+        Eigen::VectorXd res;
+
+        /// Order of the variables in our state Jacobian
+        std::vector<Type*> Hx_order;
+
+        /// If this feature passed our chi2 test
+        bool good = false;
+
+    };
+
+}
 
 
 
@@ -93,26 +113,25 @@ void UpdaterMSCKF::update(State *state, std::vector<Feature*>& feature_vec) {
     }
 
     // 3. Try to triangulate all MSCKF or new SLAM features that have measurements
+    // Each feature is independent here, so we split them across our threads and remove the failed ones afterwards in order
+    // Each thread triangulates and refines its whole chunk of features as a single batch
+    // Note that we use char here since std::vector<bool> is bit-packed and so not safe to write from multiple threads
+    std::vector<char> feat_success(feature_vec.size(), false);
+    parallel_for("msckf_triangulate", feature_vec.size(), [&](size_t start, size_t end) {
+        std::vector<Feature*> feats(feature_vec.begin()+start, feature_vec.begin()+end);
+        std::vector<char> success;
+        initializer_feat->batch_triangulation(feats, clones_cam, success);
+        std::copy(success.begin(), success.end(), feat_success.begin()+start);
+    });
     auto it1 = feature_vec.begin();
+    size_t ct_feat = 0;
     while(it1 != feature_vec.end()) {
-
-        // Triangulate the feature and remove if it fails
-        bool success = initializer_feat->single_triangulation(*it1, clones_cam);
-        if(!success) {
-            (*it1)->to_delete = true;
-            it1 = feature_vec.erase(it1);
-            continue;
-        }
-
-        // Gauss-newton refine the feature
-        success = initializer_feat->single_gaussnewton(*it1, clones_cam);
-        if(!success) {
+        if(!feat_success.at(ct_feat++)) {
             (*it1)->to_delete = true;
             it1 = feature_vec.erase(it1);
             continue;
         }
         it1++;
-
     }
     rT2 =  boost::posix_time::microsec_clock::local_time();
 
@@ -132,9 +151,19 @@ void UpdaterMSCKF::update(State *state, std::vector<Feature*>& feature_vec) {
         max_hx_size -= landmark.second->size();
     }
 
+    // Decide if we should do our update in information form
+    // Stacking and compressing costs an O(m*n^2) QR along with a large Jacobian, while the information form costs O(n^3)
+    // Note that each feature will lose three rows after nullspace projection, and that the square-root covariance needs the stacked form
+    size_t est_meas_size = (max_meas_size > 3*feature_vec.size())? max_meas_size - 3*feature_vec.size() : 0;
+    bool use_information = !state->_options.use_sqrt_covariance && est_meas_size > max_hx_size;
+
     // Large Jacobian and residual of *all* features for this update
-    Eigen::VectorXd res_big = Eigen::VectorXd::Zero(max_meas_size);
-    Eigen::MatrixXd Hx_big = Eigen::MatrixXd::Zero(max_meas_size, max_hx_size);
+    // If we are doing the information form, then we only need to accumulate H^T*H and H^T*res for each feature
+    // The large Jacobian is stacked in the precision of our covariance, and only the compression QR is done in double
+    Eigen::VectorXd res_big = Eigen::VectorXd::Zero(use_information? 0 : max_meas_size);
+    CovMatrix Hx_big = CovMatrix::Zero(use_information? 0 : max_meas_size, max_hx_size);
+    Eigen::MatrixXd Lambda_big = Eigen::MatrixXd::Zero(use_information? max_hx_size : 0, use_information? max_hx_size : 0);
+    Eigen::VectorXd b_big = Eigen::VectorXd::Zero(use_information? max_hx_size : 0);
     std::unordered_map<Type*,size_t> Hx_mapping;
     std::vector<Type*> Hx_order_big;
     size_t ct_jacob = 0;
@@ -142,73 +171,93 @@ void UpdaterMSCKF::update(State *state, std::vector<Feature*>& feature_vec) {
 
 
     // 4. Compute linear system for each feature, nullspace project, and reject
-    auto it2 = feature_vec.begin();
-    while(it2 != feature_vec.end()) {
+    // This is done in parallel, with each thread writing into the systems of the features it owns
+    // We then merge all good features in their original order, so we get the same system as if done serially
+    std::vector<FeatureLinsys> feat_systems(feature_vec.size());
+    parallel_for("msckf_linsys", feature_vec.size(), [&](size_t start, size_t end) {
 
-        // Convert our feature into our current format
-        UpdaterHelper::UpdaterHelperFeature feat;
-        feat.featid = (*it2)->featid;
-        feat.uvs = (*it2)->uvs;
-        feat.uvs_norm = (*it2)->uvs_norm;
-        feat.timestamps = (*it2)->timestamps;
-
-        // If we are using single inverse depth, then it is equivalent to using the msckf inverse depth
-        feat.feat_representation = state->_options.feat_rep_msckf;
-        if(state->_options.feat_rep_msckf==LandmarkRepresentation::Representation::ANCHORED_INVERSE_DEPTH_SINGLE) {
-            feat.feat_representation = LandmarkRepresentation::Representation::ANCHORED_MSCKF_INVERSE_DEPTH;
-        }
+        // Feature Jacobian buffer which is reused by all features of this thread
+        Eigen::MatrixXd H_f;
 
-        // Save the position and its fej value
-        if(LandmarkRepresentation::is_relative_representation(feat.feat_representation)) {
-            feat.anchor_cam_id = (*it2)->anchor_cam_id;
-            feat.anchor_clone_timestamp = (*it2)->anchor_clone_timestamp;
-            feat.p_FinA = (*it2)->p_FinA;
-            feat.p_FinA_fej = (*it2)->p_FinA;
-        } else {
-            feat.p_FinG = (*it2)->p_FinG;
-            feat.p_FinG_fej = (*it2)->p_FinG;
-        }
+        for(size_t i=start; i<end; i++) {
 
-        // Our return values (feature jacobian, state jacobian, residual, and order of state jacobian)
-        Eigen::MatrixXd H_f;
-        Eigen::MatrixXd H_x;
-        Eigen::VectorXd res;
-        std::vector<Type*> Hx_order;
+            // Convert our feature into our current format
+            UpdaterHelper::UpdaterHelperFeature feat;
+            feat.featid = feature_vec.at(i)->featid;
+            feat.uvs = &feature_vec.at(i)->uvs;
+            feat.uvs_norm = &feature_vec.at(i)->uvs_norm;
+            feat.timestamps = &feature_vec.at(i)->timestamps;
 
-        // Get the Jacobian for this feature
-        UpdaterHelper::get_feature_jacobian_full(state, feat, H_f, H_x, res, Hx_order);
+            // If we are using single inverse depth, then it is equivalent to using the msckf inverse depth
+            feat.feat_representation = state->_options.feat_rep_msckf;
+            if(state->_options.feat_rep_msckf==LandmarkRepresentation::Representation::ANCHORED_INVERSE_DEPTH_SINGLE) {
+                feat.feat_representation = LandmarkRepresentation::Representation::ANCHORED_MSCKF_INVERSE_DEPTH;
+            }
 
-        // Nullspace project
-        UpdaterHelper::nullspace_project_inplace(H_f, H_x, res);
+            // Save the position and its fej value
+            if(LandmarkRepresentation::is_relative_representation(feat.feat_representation)) {
+                feat.anchor_cam_id = feature_vec.at(i)->anchor_cam_id;
+                feat.anchor_clone_timestamp = feature_vec.at(i)->anchor_clone_timestamp;
+                feat.p_FinA = feature_vec.at(i)->p_FinA;
+                feat.p_FinA_fej = feature_vec.at(i)->p_FinA;
+            } else {
+                feat.p_FinG = feature_vec.at(i)->p_FinG;
+                feat.p_FinG_fej = feature_vec.at(i)->p_FinG;
+            }
 
-        /// Chi2 distance check
-        Eigen::MatrixXd P_marg = StateHelper::get_marginal_covariance(state, Hx_order);
-        Eigen::MatrixXd S = H_x*P_marg*H_x.transpose();
-        S.diagonal() += _options.sigma_pix_sq*Eigen::VectorXd::Ones(S.rows());
-        double chi2 = res.dot(S.llt().solve(res));
+            // Our return values (state jacobian, residual, and order of state jacobian)
+            Eigen::MatrixXd &H_x = feat_systems.at(i).H_x;
+            Eigen::VectorXd &res = feat_systems.at(i).res;
+            std::vector<Type*> &Hx_order = feat_systems.at(i).Hx_order;
+
+            // Get the Jacobian for this feature
+            UpdaterHelper::get_feature_jacobian_full(state, feat, H_f, H_x, res, Hx_order);
+
+            // Nullspace project
+            UpdaterHelper::nullspace_project_inplace(H_f, H_x, res);
+
+            /// Chi2 distance check
+            Eigen::MatrixXd P_marg = StateHelper::get_marginal_covariance(state, Hx_order);
+            Eigen::MatrixXd S = H_x*P_marg*H_x.transpose();
+            S.diagonal() += _options.sigma_pix_sq*Eigen::VectorXd::Ones(S.rows());
+            double chi2 = res.dot(S.llt().solve(res));
+
+            // Get our threshold (we precompute up to 500 but handle the case that it is more)
+            // Note that we use at() since the table is shared between all threads and must not be modified
+            double chi2_check;
+            if(res.rows() < 500) {
+                chi2_check = chi_squared_table.at(res.rows());
+            } else {
+                boost::math::chi_squared chi_squared_dist(res.rows());
+                chi2_check = boost::math::quantile(chi_squared_dist, 0.95);
+                printf(YELLOW "chi2_check over the residual limit - %d\n" RESET, (int)res.rows());
+            }
+
+            // Check if we should delete or not
+            feat_systems.at(i).good = !(chi2 > _options.chi2_multipler*chi2_check);
 
-        // Get our threshold (we precompute up to 500 but handle the case that it is more)
-        double chi2_check;
-        if(res.rows() < 500) {
-            chi2_check = chi_squared_table[res.rows()];
-        } else {
-            boost::math::chi_squared chi_squared_dist(res.rows());
-            chi2_check = boost::math::quantile(chi_squared_dist, 0.95);
-            printf(YELLOW "chi2_check over the residual limit - %d\n" RESET, (int)res.rows());
         }
+    });
+
+    // Merge all our good features into our large system
+    auto it2 = feature_vec.begin();
+    size_t ct_sys = 0;
+    while(it2 != feature_vec.end()) {
 
-        // Check if we should delete or not
-        if(chi2 > _options.chi2_multipler*chi2_check) {
+        // Remove the feature if it failed the chi2 test
+        const FeatureLinsys &sys = feat_systems.at(ct_sys++);
+        const Eigen::MatrixXd &H_x = sys.H_x;
+        const Eigen::VectorXd &res = sys.res;
+        const std::vector<Type*> &Hx_order = sys.Hx_order;
+        if(!sys.good) {
             (*it2)->to_delete = true;
             it2 = feature_vec.erase(it2);
-            //cout << "featid = " << feat.featid << endl;
-            //cout << "chi2 = " << chi2 << " > " << _options.chi2_multipler*chi2_check << endl;
-            //cout << "res = " << endl << res.transpose() << endl;
             continue;
         }
 
         // We are good!!! Append to our large H vector
         size_t ct_hx = 0;
+        std::vector<size_t> Hx_loc;
         for(const auto &var : Hx_order) {
 
             // Ensure that this variable is in our Jacobian
@@ -217,15 +266,40 @@ void UpdaterMSCKF::update(State *state, std::vector<Feature*>& feature_vec) {
                 Hx_order_big.push_back(var);
                 ct_jacob += var->size();
             }
+            Hx_loc.push_back(Hx_mapping[var]);
 
             // Append to our large Jacobian
-            Hx_big.block(ct_meas,Hx_mapping[var],H_x.rows(),var->size()) = H_x.block(0,ct_hx,H_x.rows(),var->size());
+            if(!use_information) {
+                Hx_big.block(ct_meas,Hx_mapping[var],H_x.rows(),var->size()) = H_x.block(0,ct_hx,H_x.rows(),var->size()).cast<CovScalar>();
+            }
             ct_hx += var->size();
 
         }
 
+        // If in information form, accumulate this feature's information H^T*H and H^T*res into our large system
+        // Note that we only keep the upper triangular of our large information matrix valid
+        if(use_information) {
+            Eigen::MatrixXd HtH = H_x.transpose()*H_x;
+            Eigen::VectorXd Htr = H_x.transpose()*res;
+            size_t ct_i = 0;
+            for(size_t i=0; i<Hx_order.size(); i++) {
+                b_big.segment(Hx_loc[i],Hx_order[i]->size()) += Htr.segment(ct_i,Hx_order[i]->size());
+                size_t ct_k = 0;
+                for(size_t k=0; k<Hx_order.size(); k++) {
+                    if(Hx_loc[i] <= Hx_loc[k]) {
+                        Lambda_big.block(Hx_loc[i],Hx_loc[k],Hx_order[i]->size(),Hx_order[k]->size()) +=
+                                HtH.block(ct_i,ct_k,Hx_order[i]->size(),Hx_order[k]->size());
+                    }
+                    ct_k += Hx_order[k]->size();
+                }
+                ct_i += Hx_order[i]->size();
+            }
+        }
+
         // Append our residual and move forward
-        res_big.block(ct_meas,0,res.rows(),1) = res;
+        if(!use_information) {
+            res_big.block(ct_meas,0,res.rows(),1) = res;
+        }
         ct_meas += res.rows();
         it2++;
 
@@ -244,13 +318,23 @@ void UpdaterMSCKF::update(State *state, std::vector<Feature*>& feature_vec) {
     }
     assert(ct_meas<=max_meas_size);
     assert(ct_jacob<=max_hx_size);
+
+    // If we are in information form, then we can directly update with our accumulated system
+    // Our noise is isotropic, so R^{-1} is just a scaling of our information
+    if(use_information) {
+        Eigen::MatrixXd Lambda = Lambda_big.block(0,0,ct_jacob,ct_jacob)/_options.sigma_pix_sq;
+        Eigen::VectorXd b = b_big.segment(0,ct_jacob)/_options.sigma_pix_sq;
+        StateHelper::EKFUpdateInformation(state, Hx_order_big, Lambda, b);
+        return;
+    }
     res_big.conservativeResize(ct_meas,1);
     Hx_big.conservativeResize(ct_meas,ct_jacob);
 
 
     // 5. Perform measurement compression
-    UpdaterHelper::measurement_compress_inplace(Hx_big, res_big);
-    if(Hx_big.rows() < 1) {
+    Eigen::MatrixXd Hx_comp;
+    UpdaterHelper::measurement_compress(Hx_big, res_big, Hx_comp);
+    if(Hx_comp.rows() < 1) {
         return;
     }
     rT4 =  boost::posix_time::microsec_clock::local_time();
@@ -260,7 +344,7 @@ void UpdaterMSCKF::update(State *state, std::vector<Feature*>& feature_vec) {
     Eigen::MatrixXd R_big = _options.sigma_pix_sq*Eigen::MatrixXd::Identity(res_big.rows(),res_big.rows());
 
     // 6. With all good features update the state
-    StateHelper::EKFUpdate(state, Hx_order_big, Hx_big, res_big, R_big);
+    StateHelper::EKFUpdate(state, Hx_order_big, Hx_comp, res_big, R_big);
     rT5 =  boost::posix_time::microsec_clock::local_time();
 
     // Debug print timing information
@@ -275,6 +359,36 @@ void UpdaterMSCKF::update(State *state, std::vector<Feature*>& feature_vec) {
 
 
 
+void UpdaterMSCKF::parallel_for(const std::string &name, size_t num_items, const std::function<void(size_t,size_t)> &func) {
+
+    // Nothing to do if we have no items
+    if(num_items < 1)
+        return;
+
+    // Just call the function directly if we have no workers to share with
+    size_t num_chunks = std::min(pool->num_threads()+1, num_items);
+    if(num_chunks == 1) {
+        func(0, num_items);
+        return;
+    }
+
+    // Split into contiguous chunks, one for each worker and one for our calling thread
+    // The pool will re-throw any exception of a chunk once all of them are done
+    size_t chunk = num_items/num_chunks;
+    size_t extra = num_items%num_chunks;
+    std::vector<TaskPool::Task> tasks;
+    size_t start = 0;
+    for(size_t t=0; t<num_chunks; t++) {
+        size_t end = start + chunk + ((t < extra)? 1 : 0);
+        tasks.push_back({name, [&func, start, end] { func(start, end); }});
+        start = end;
+    }
+    pool->run(tasks);
+
+}
+
+
+
 
 
 
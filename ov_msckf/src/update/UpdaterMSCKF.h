@@ -31,10 +31,12 @@
 #include "feat/FeatureInitializerOptions.h"
 #include "utils/quat_ops.h"
 #include "utils/colors.h"
+#include "utils/TaskPool.h"
 
 #include "UpdaterHelper.h"
 #include "UpdaterOptions.h"
 
+#include <functional>
 #include <boost/math/distributions/chi_squared.hpp>
 #include <boost/date_time/posix_time/posix_time.hpp>
 
@@ -64,7 +66,7 @@ namespace ov_msckf {
          * @param options Updater options (include measurement noise value)
          * @param feat_init_options Feature initializer options
          */
-        UpdaterMSCKF(UpdaterOptions &options, FeatureInitializerOptions &feat_init_options) : _options(options) {
+        UpdaterMSCKF(UpdaterOptions &options, FeatureInitializerOptions &feat_init_options) : _options(options), pool(new TaskPool(0)) {
 
             // Save our raw pixel noise squared
             _options.sigma_pix_sq = std::pow(_options.sigma_pix,2);
@@ -91,10 +93,36 @@ namespace ov_msckf {
         void update(State *state, std::vector<Feature*>& feature_vec);
 
 
+        /**
+         * @brief Sets the pool of threads we will give the per-feature work of an update to
+         *
+         * By default we have a pool without any workers, so everything is done on the thread calling update().
+         * Should not be called while we are updating.
+         *
+         * @param taskpool Pool that we should use
+         */
+        void set_task_pool(std::shared_ptr<TaskPool> taskpool) {
+            pool = taskpool;
+        }
+
+
 
     protected:
 
 
+        /**
+         * @brief Will split the items into contiguous chunks and process them in parallel on our task pool.
+         *
+         * The calling thread processes the first chunk, and this will only return once all chunks are done.
+         * Results should be written by index so they can be merged in order afterwards.
+         *
+         * @param name Name of the chunk tasks, used for the timing of our pool
+         * @param num_items Number of items we want to process
+         * @param func Function which will process all items in [start,end)
+         */
+        void parallel_for(const std::string &name, size_t num_items, const std::function<void(size_t,size_t)> &func);
+
+
         /// Options used during update
         UpdaterOptions _options;
 
@@ -104,6 +132,9 @@ namespace ov_msckf {
         /// Chi squared 95th percentile table (lookup would be size of residual)
         std::map<int, double> chi_squared_table;
 
+        /// Pool of threads we give our per-feature work to
+        std::shared_ptr<TaskPool> pool;
+
 
     };
 
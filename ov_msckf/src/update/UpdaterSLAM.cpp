@@ -90,26 +90,18 @@ void UpdaterSLAM::delayed_init(State *state, std::vector<Feature*>& feature_vec)
     }
 
     // 3. Try to triangulate all MSCKF or new SLAM features that have measurements
+    // These are all triangulated and refined as a single batch, and then we remove the ones that failed
+    std::vector<char> feat_success;
+    initializer_feat->batch_triangulation(feature_vec, clones_cam, feat_success);
     auto it1 = feature_vec.begin();
+    size_t ct_feat = 0;
     while(it1 != feature_vec.end()) {
-
-        // Triangulate the feature and remove if it fails
-        bool success = initializer_feat->single_triangulation(*it1, clones_cam);
-        if(!success) {
-            (*it1)->to_delete = true;
-            it1 = feature_vec.erase(it1);
-            continue;
-        }
-
-        // Gauss-newton refine the feature
-        success = initializer_feat->single_gaussnewton(*it1, clones_cam);
-        if(!success) {
+        if(!feat_success.at(ct_feat++)) {
             (*it1)->to_delete = true;
             it1 = feature_vec.erase(it1);
             continue;
         }
         it1++;
-
     }
     rT2 =  boost::posix_time::microsec_clock::local_time();
 
@@ -121,9 +113,9 @@ void UpdaterSLAM::delayed_init(State *state, std::vector<Feature*>& feature_vec)
         // Convert our feature into our current format
         UpdaterHelper::UpdaterHelperFeature feat;
         feat.featid = (*it2)->featid;
-        feat.uvs = (*it2)->uvs;
-        feat.uvs_norm = (*it2)->uvs_norm;
-        feat.timestamps = (*it2)->timestamps;
+        feat.uvs = &(*it2)->uvs;
+        feat.uvs_norm = &(*it2)->uvs_norm;
+        feat.timestamps = &(*it2)->timestamps;
 
         // If we are using single inverse depth, then it is equivalent to using the msckf inverse depth
         auto feat_rep = ((int)feat.featid < state->_options.max_aruco_features)? state->_options.feat_rep_aruco : state->_options.feat_rep_slam;
@@ -304,9 +296,9 @@ void UpdaterSLAM::update(State *state, std::vector<Feature*>& feature_vec) {
         // Convert the state landmark into our current format
         UpdaterHelper::UpdaterHelperFeature feat;
         feat.featid = (*it2)->featid;
-        feat.uvs = (*it2)->uvs;
-        feat.uvs_norm = (*it2)->uvs_norm;
-        feat.timestamps = (*it2)->timestamps;
+        feat.uvs = &(*it2)->uvs;
+        feat.uvs_norm = &(*it2)->uvs_norm;
+        feat.timestamps = &(*it2)->timestamps;
 
         // If we are using single inverse depth, then it is equivalent to using the msckf inverse depth
         feat.feat_representation = landmark->_feat_representation;
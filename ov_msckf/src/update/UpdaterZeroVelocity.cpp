@@ -27,7 +27,7 @@ using namespace ov_msckf;
 bool UpdaterZeroVelocity::try_update(State *state, double timestamp) {
 
     // Return if we don't have any imu data yet
-    if(imu_data.empty())
+    if(imu_data->empty())
         return false;
 
     // Set the last time offset value if we have just started the system up
@@ -48,7 +48,7 @@ bool UpdaterZeroVelocity::try_update(State *state, double timestamp) {
     double time1 = timestamp+t_off_new;
 
     // Select bounding inertial measurements
-    std::vector<Propagator::IMUDATA> imu_recent = Propagator::select_imu_readings(imu_data, time0, time1);
+    std::vector<Propagator::IMUDATA> imu_recent = Propagator::select_imu_readings(*imu_data, time0, time1);
 
     // Move forward in time
     last_prop_time_offset = t_off_new;
@@ -129,7 +129,7 @@ bool UpdaterZeroVelocity::try_update(State *state, double timestamp) {
 
     // Next propagate the biases forward in time
     // NOTE: G*Qd*G^t = dt*Qd*dt = dt*Qc
-    Eigen::MatrixXd Q_bias = Eigen::MatrixXd::Identity(6,6);
+    Eigen::Matrix<double,6,6> Q_bias = Eigen::Matrix<double,6,6>::Identity();
     Q_bias.block(0,0,3,3) *= dt_summed*_noises.sigma_wb;
     Q_bias.block(3,3,3,3) *= dt_summed*_noises.sigma_ab;
 
@@ -161,11 +161,11 @@ bool UpdaterZeroVelocity::try_update(State *state, double timestamp) {
     // Next propagate the biases forward in time
     // NOTE: G*Qd*G^t = dt*Qd*dt = dt*Qc
     if(model_time_varying_bias) {
-        Eigen::MatrixXd Phi_bias = Eigen::MatrixXd::Identity(6,6);
+        Eigen::Matrix<double,6,6> Phi_bias = Eigen::Matrix<double,6,6>::Identity();
         std::vector<Type*> Phi_order;
         Phi_order.push_back(state->_imu->bg());
         Phi_order.push_back(state->_imu->ba());
-        StateHelper::EKFPropagation(state, Phi_order, Phi_order, Phi_bias, Q_bias);
+        StateHelper::EKFPropagation<6>(state, Phi_order, Phi_bias, Q_bias);
     }
 
     // Else we are good, update the system
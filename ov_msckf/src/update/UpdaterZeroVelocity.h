@@ -60,9 +60,12 @@ namespace ov_msckf {
          * @param gravity Global gravity of the system (normally [0,0,9.81])
          * @param zupt_max_velocity Max velocity we should consider to do a update with
          * @param zupt_noise_multiplier Multiplier of our IMU noise matrix (default should be 1.0)
+         * @param imu_data History of IMU messages we will read from (shared with the propagator)
          */
-        UpdaterZeroVelocity(UpdaterOptions &options, Propagator::NoiseManager &noises, Eigen::Vector3d gravity, double zupt_max_velocity, double zupt_noise_multiplier)
-                            : _options(options), _noises(noises), _gravity(gravity), _zupt_max_velocity(zupt_max_velocity), _zupt_noise_multiplier(zupt_noise_multiplier) {
+        UpdaterZeroVelocity(UpdaterOptions &options, Propagator::NoiseManager &noises, Eigen::Vector3d gravity, double zupt_max_velocity, double zupt_noise_multiplier,
+                            std::shared_ptr<ImuBuffer> imu_data)
+                            : _options(options), _noises(noises), _gravity(gravity), _zupt_max_velocity(zupt_max_velocity), _zupt_noise_multiplier(zupt_noise_multiplier),
+                              imu_data(imu_data) {
 
             // Save our raw pixel noise squared
             _noises.sigma_w_2 = std::pow(_noises.sigma_w,2);
@@ -80,43 +83,6 @@ namespace ov_msckf {
         }
 
 
-        /**
-         * @brief Stores incoming inertial readings
-         * @param timestamp Timestamp of imu reading
-         * @param wm Gyro angular velocity reading
-         * @param am Accelerometer linear acceleration reading
-         */
-        void feed_imu(double timestamp, Eigen::Vector3d wm, Eigen::Vector3d am) {
-
-            // Create our imu data object
-            Propagator::IMUDATA data;
-            data.timestamp = timestamp;
-            data.wm = wm;
-            data.am = am;
-
-            // Append it to our vector
-            imu_data.emplace_back(data);
-
-            // Sort our imu data (handles any out of order measurements)
-            //std::sort(imu_data.begin(), imu_data.end(), [](const IMUDATA i, const IMUDATA j) {
-            //    return i.timestamp < j.timestamp;
-            //});
-
-            // Loop through and delete imu messages that are older then 20 seconds
-            // TODO: we should probably have more elegant logic then this
-            // TODO: but this prevents unbounded memory growth and slow prop with high freq imu
-            auto it0 = imu_data.begin();
-            while(it0 != imu_data.end()) {
-                if(timestamp-(*it0).timestamp > 60) {
-                    it0 = imu_data.erase(it0);
-                } else {
-                    it0++;
-                }
-            }
-
-        }
-
-
         /**
          * @brief Will first detect if the system is zero velocity, then will update.
          * @param state State of the filter
@@ -126,6 +92,20 @@ namespace ov_msckf {
         bool try_update(State *state, double timestamp);
 
 
+        /**
+         * @brief Gets the time offset that our last zero velocity check ended with
+         *
+         * After a successful update, the imu state is at the state time plus this offset (t_imu = t_cam + offset).
+         *
+         * @param offset Time offset of our last check
+         * @return False if we have not checked yet
+         */
+        bool get_last_prop_time_offset(double &offset) {
+            offset = last_prop_time_offset;
+            return have_last_prop_time_offset;
+        }
+
+
 
     protected:
 
@@ -148,8 +128,8 @@ namespace ov_msckf {
         /// Chi squared 95th percentile table (lookup would be size of residual)
         std::map<int, double> chi_squared_table;
 
-        /// Our history of IMU messages (time, angular, linear)
-        std::vector<Propagator::IMUDATA> imu_data;
+        /// Our history of IMU messages (time, angular, linear), this is shared with the propagator
+        std::shared_ptr<ImuBuffer> imu_data;
 
         /// Estimate for time offset at last propagation time
         double last_prop_time_offset = -INFINITY;
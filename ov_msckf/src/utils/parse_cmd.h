@@ -52,6 +52,9 @@ namespace ov_msckf {
         app1.add_option("--use_fej", params.state_options.do_fej, "");
         app1.add_option("--use_imuavg", params.state_options.imu_avg, "");
         app1.add_option("--use_rk4int", params.state_options.use_rk4_integration, "");
+        app1.add_option("--prop_cpi_model", params.state_options.prop_cpi_model, "");
+        app1.add_option("--use_sqrt_cov", params.state_options.use_sqrt_covariance, "");
+        app1.add_option("--use_diagnostics", params.state_options.do_diagnostics, "");
         app1.add_option("--calib_cam_extrinsics", params.state_options.do_calib_camera_pose, "");
         app1.add_option("--calib_cam_intrinsics", params.state_options.do_calib_camera_intrinsics, "");
         app1.add_option("--calib_cam_timeoffset", params.state_options.do_calib_camera_timeoffset, "");
@@ -74,6 +77,7 @@ namespace ov_msckf {
         // Filter initialization
         app1.add_option("--init_window_time", params.init_window_time, "");
         app1.add_option("--init_imu_thresh", params.init_imu_thresh, "");
+        app1.add_option("--imu_history_size", params.imu_history_size, "");
 
         // Zero velocity update
         app1.add_option("--try_zupt", params.try_zupt, "");
@@ -84,6 +88,10 @@ namespace ov_msckf {
         // Recording of timing information to file
         app1.add_option("--record_timing_information", params.record_timing_information, "");
         app1.add_option("--record_timing_filepath", params.record_timing_filepath, "");
+        app1.add_option("--use_async_pipeline", params.use_async_pipeline, "");
+        app1.add_option("--async_queue_size", params.async_queue_size, "");
+        app1.add_option("--async_drop_frames", params.async_drop_frames, "");
+        app1.add_option("--use_imu_rate_output", params.use_imu_rate_output, "");
 
         // NOISE ======================================================================
 
@@ -116,10 +124,23 @@ namespace ov_msckf {
 
         // Tracking flags
         app1.add_option("--use_stereo", params.use_stereo, "");
+        std::vector<int> stereo_pairs;
+        for(const auto &pair : params.stereo_pairs) {
+            stereo_pairs.push_back((int)pair.first);
+            stereo_pairs.push_back((int)pair.second);
+        }
+        app1.add_option("--stereo_pairs", stereo_pairs, "");
         app1.add_option("--use_klt", params.use_klt, "");
         app1.add_option("--use_aruco", params.use_aruco, "");
         app1.add_option("--downsize_aruco", params.downsize_aruco, "");
         app1.add_option("--downsample_cameras", params.downsample_cameras, "");
+        app1.add_option("--use_lockfree_feed", params.use_lockfree_feed, "");
+        app1.add_option("--lockfree_feed_size", params.lockfree_feed_size, "");
+        app1.add_option("--num_task_threads", params.num_task_threads, "");
+        app1.add_option("--task_pool_cpus", params.task_pool_cpus, "");
+        app1.add_option("--use_undistort_lut", params.use_undistort_lut, "");
+        app1.add_option("--undistort_lut_step", params.undistort_lut_step, "");
+        app1.add_option("--undistort_lut_tolerance", params.undistort_lut_tolerance, "");
 
         // General parameters
         app1.add_option("--num_pts", params.num_pts, "");
@@ -192,6 +213,13 @@ namespace ov_msckf {
         assert(gravity.size()==3);
         params.gravity << gravity.at(0), gravity.at(1), gravity.at(2);
 
+        // Parse our stereo pairs (flat list of left and right camera ids)
+        assert(stereo_pairs.size()%2==0);
+        params.stereo_pairs.clear();
+        for(size_t i=0; i+1<stereo_pairs.size(); i+=2) {
+            params.stereo_pairs.push_back({(size_t)stereo_pairs.at(i), (size_t)stereo_pairs.at(i+1)});
+        }
+
         // Enforce that we have enough cameras to run
         if(params.state_options.num_cameras < 1) {
             printf(RED "VioManager(): Specified number of cameras needs to be greater than zero\n" RESET);
@@ -48,6 +48,9 @@ namespace ov_msckf {
         nh.param<bool>("use_fej", params.state_options.do_fej, params.state_options.do_fej);
         nh.param<bool>("use_imuavg", params.state_options.imu_avg, params.state_options.imu_avg);
         nh.param<bool>("use_rk4int", params.state_options.use_rk4_integration, params.state_options.use_rk4_integration);
+        nh.param<int>("prop_cpi_model", params.state_options.prop_cpi_model, params.state_options.prop_cpi_model);
+        nh.param<bool>("use_sqrt_cov", params.state_options.use_sqrt_covariance, params.state_options.use_sqrt_covariance);
+        nh.param<bool>("use_diagnostics", params.state_options.do_diagnostics, params.state_options.do_diagnostics);
         nh.param<bool>("calib_cam_extrinsics", params.state_options.do_calib_camera_pose, params.state_options.do_calib_camera_pose);
         nh.param<bool>("calib_cam_intrinsics", params.state_options.do_calib_camera_intrinsics, params.state_options.do_calib_camera_intrinsics);
         nh.param<bool>("calib_cam_timeoffset", params.state_options.do_calib_camera_timeoffset, params.state_options.do_calib_camera_timeoffset);
@@ -97,6 +100,7 @@ namespace ov_msckf {
         // Filter initialization
         nh.param<double>("init_window_time", params.init_window_time, params.init_window_time);
         nh.param<double>("init_imu_thresh", params.init_imu_thresh, params.init_imu_thresh);
+        nh.param<int>("imu_history_size", params.imu_history_size, params.imu_history_size);
 
         // Zero velocity update
         nh.param<bool>("try_zupt", params.try_zupt, params.try_zupt);
@@ -107,6 +111,10 @@ namespace ov_msckf {
         // Recording of timing information to file
         nh.param<bool>("record_timing_information", params.record_timing_information, params.record_timing_information);
         nh.param<std::string>("record_timing_filepath", params.record_timing_filepath, params.record_timing_filepath);
+        nh.param<bool>("use_async_pipeline", params.use_async_pipeline, params.use_async_pipeline);
+        nh.param<int>("async_queue_size", params.async_queue_size, params.async_queue_size);
+        nh.param<bool>("async_drop_frames", params.async_drop_frames, params.async_drop_frames);
+        nh.param<bool>("use_imu_rate_output", params.use_imu_rate_output, params.use_imu_rate_output);
 
 
         // NOISE ======================================================================
@@ -142,10 +150,28 @@ namespace ov_msckf {
 
         // Tracking flags
         nh.param<bool>("use_stereo", params.use_stereo, params.use_stereo);
+        std::vector<int> stereo_pairs;
+        for(const auto &pair : params.stereo_pairs) {
+            stereo_pairs.push_back((int)pair.first);
+            stereo_pairs.push_back((int)pair.second);
+        }
+        nh.param<std::vector<int>>("stereo_pairs", stereo_pairs, stereo_pairs);
+        assert(stereo_pairs.size()%2==0);
+        params.stereo_pairs.clear();
+        for(size_t i=0; i+1<stereo_pairs.size(); i+=2) {
+            params.stereo_pairs.push_back({(size_t)stereo_pairs.at(i), (size_t)stereo_pairs.at(i+1)});
+        }
         nh.param<bool>("use_klt", params.use_klt, params.use_klt);
         nh.param<bool>("use_aruco", params.use_aruco, params.use_aruco);
         nh.param<bool>("downsize_aruco", params.downsize_aruco, params.downsize_aruco);
         nh.param<bool>("downsample_cameras", params.downsample_cameras, params.downsample_cameras);
+        nh.param<bool>("use_lockfree_feed", params.use_lockfree_feed, params.use_lockfree_feed);
+        nh.param<int>("lockfree_feed_size", params.lockfree_feed_size, params.lockfree_feed_size);
+        nh.param<int>("num_task_threads", params.num_task_threads, params.num_task_threads);
+        nh.param<std::vector<int>>("task_pool_cpus", params.task_pool_cpus, params.task_pool_cpus);
+        nh.param<bool>("use_undistort_lut", params.use_undistort_lut, params.use_undistort_lut);
+        nh.param<int>("undistort_lut_step", params.undistort_lut_step, params.undistort_lut_step);
+        nh.param<double>("undistort_lut_tolerance", params.undistort_lut_tolerance, params.undistort_lut_tolerance);
 
         // General parameters
         nh.param<int>("num_pts", params.num_pts, params.num_pts);